@@ -1,10 +1,14 @@
 #ifndef __ANIMATOR_CPP__
 #define __ANIMATOR_CPP__
 
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
-#include <iomanip>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <sys/ioctl.h>
+#include <unistd.h>
 #include "Animator.h"
 
 // used for drawing width -- can be defined by user
@@ -27,43 +31,75 @@ const std::string Animator::COLOR_BLUE_BG   = "\033[44m\033[1;37m";
 const std::string Animator::COLOR_YELLOW_BG = "\033[43m\033[1;37m";
 const std::string Animator::COLOR_RESET     = "\033[0m";
 
-std::string Animator::GREEN_LIGHT = "";
-std::string Animator::YELLOW_LIGHT = "";
-std::string Animator::RED_LIGHT = "";
+// indexed by Style, in the order the enum lists them
+const std::string* const Animator::STYLE_CODES[] = {
+    &Animator::COLOR_RESET,
+    &Animator::COLOR_RED_FG,  &Animator::COLOR_GREEN_FG,  &Animator::COLOR_BLUE_FG,
+    &Animator::COLOR_RED_BG,  &Animator::COLOR_GREEN_BG,  &Animator::COLOR_BLUE_BG,
+    &Animator::COLOR_YELLOW_BG
+};
 
 const std::string Animator::SECTION_BOUNDARY_NS = "|";
 const std::string Animator::ERROR_MSG =
     "Error in Animator::draw: must call all four Animator::setVehicles* methods prior to calling Animator::draw";
 
+// writes the decimal digits of value so that they end just before end and
+// returns where they start
+static char* formatDigits(unsigned long value, char* end)
+{
+    do
+    {
+        *--end = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    return end;
+}
+
 //======================================================================
 //* Animator::Animator(int numSectionsBeforeIntersection)
 //======================================================================
 Animator::Animator(int numSectionsBeforeIntersection)
 {
     // redo here in case the user set MAX_VEHCILE_COUNT differently
-    Animator::DIGITS_TO_DRAW = Animator::MAX_VEHICLE_COUNT <= 1 ? 
+    Animator::DIGITS_TO_DRAW = Animator::MAX_VEHICLE_COUNT <= 1 ?
         2 : static_cast<int>(log10(Animator::MAX_VEHICLE_COUNT)) + 1;
     Animator::SECTION_BOUNDARY_EW = std::string(Animator::DIGITS_TO_DRAW, '-');
     Animator::EMPTY_SECTION = std::string(Animator::DIGITS_TO_DRAW, ' ');
 
-    // these will use the redone DIGITS TO DRAW above
-    Animator::GREEN_LIGHT  = createLight(LightColor::green);
-    Animator::YELLOW_LIGHT = createLight(LightColor::yellow);
-    Animator::RED_LIGHT    = createLight(LightColor::red);
-
     numSectionsBefore = numSectionsBeforeIntersection;
 
-    // each lane will be twice the number of sections provided (before and 
+    // each lane will be twice the number of sections provided (before and
     // after the intersection) plus the two intersection sections
-    eastToWest.resize(numSectionsBefore * 2 + 2);
-    westToEast.resize(numSectionsBefore * 2 + 2);
-    northToSouth.resize(numSectionsBefore * 2 + 2);
-    southToNorth.resize(numSectionsBefore * 2 + 2);
+    laneLength = numSectionsBefore * 2 + 2;
 
-    // this will set the values in the vector to 0 (false), indicating that
     // the user must set the vehicles in each of the four directions using the
     // setVehicles* functions
-    vehiclesAreSet.resize(4);
+    for (int d = 0; d < 4; d++)
+        vehiclesAreSet[d] = false;
+
+    // lay out the picture once; every frame after this only fills in the slots
+    skeleton.push_back(Piece{ {}, SLOT_NONE, Direction::north, 0, Direction::north, -1 });
+    drawNorthPortion();
+    drawWestbound();
+    drawEastbound();
+    drawSouthPortion();
+    emptySection.assign(Animator::DIGITS_TO_DRAW, Cell{' ', STYLE_NONE});
+
+    // room for a whole frame (with a few wider IDs) and its escape sequences,
+    // so drawing doesn't allocate
+    size_t cells = 0;
+    for (size_t p = 0; p < skeleton.size(); p++)
+        cells += skeleton[p].text.size() + 2 * Animator::DIGITS_TO_DRAW;
+    frame.reserve(cells);
+    shown.reserve(cells);
+    frameRowStart.reserve(skeleton.size());
+    shownRowStart.reserve(skeleton.size());
+    output.reserve(cells * 8);
+
+    // nothing is on the terminal yet, so the first draw is a full redraw
+    shownIsValid = false;
+    terminalRows = 0;
+    terminalColumns = 0;
 }
 
 //======================================================================
@@ -72,172 +108,443 @@ Animator::Animator(int numSectionsBeforeIntersection)
 Animator::~Animator() {}
 
 //======================================================================
-//* std::string Animator::createLight(LightColor color)
+//* Animator::draw(int time)
 //======================================================================
-std::string Animator::createLight(LightColor color)
+void Animator::draw(int time)
 {
-    std::string light = "";
-
-    if (color == LightColor::green)  light += Animator::COLOR_GREEN_BG;
-    if (color == LightColor::yellow) light += Animator::COLOR_YELLOW_BG;
-    if (color == LightColor::red)    light += Animator::COLOR_RED_BG;
-
-    light += std::string(2, ' ') + Animator::COLOR_RESET;
-
-    return light;
+    // ensure all four setVehicles* methods have been called prior
+    for (int d = 0; d < 4; d++)
+        if (!vehiclesAreSet[d]) throw std::runtime_error(Animator::ERROR_MSG.c_str());
+
+    compose(time);
+    int lines = frameRowStart.size() - 1;
+
+    // a resized terminal may have reflowed or scrolled what was on it, and a
+    // picture without a spare line below it scrolls when Enter is echoed, so
+    // in either case the old screen contents can't be trusted
+    int rows = 0;
+    int columns = 0;
+    struct winsize size;
+    if (isatty(STDOUT_FILENO) && ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0)
+    {
+        rows = size.ws_row;
+        columns = size.ws_col;
+    }
+    int width = 0;
+    for (int line = 0; line < lines; line++)
+        width = std::max(width, frameRowStart[line + 1] - frameRowStart[line]);
+    bool fits = rows == 0 || (lines + 2 <= rows && width <= columns);
+
+    output.clear();
+    if (!shownIsValid || !fits || rows != terminalRows || columns != terminalColumns)
+        renderFull();
+    else
+        renderChanges();
+    terminalRows = rows;
+    terminalColumns = columns;
+    writeOutput();
+
+    // what was just drawn is what the next frame gets compared against
+    frame.swap(shown);
+    frameRowStart.swap(shownRowStart);
+    shownIsValid = true;
+
+    // reset the flags (to false), indicating that the user must set the
+    // vehicles in each of the four directions using the setVehicles*
+    // functions (views may be stale after the simulation moves on)
+    for (int d = 0; d < 4; d++)
+        vehiclesAreSet[d] = false;
 }
 
 //======================================================================
-//* Animator::draw(int time)
+//* const LaneVehicles& Animator::vehiclesFor(Direction lane) const
 //======================================================================
-void Animator::draw(int time)
+const LaneVehicles& Animator::vehiclesFor(Direction lane) const
 {
-    // ensure all four setVehicles* methods have been called prior
-    std::vector<bool>::iterator it = vehiclesAreSet.begin();
-    for (; it != vehiclesAreSet.end(); it++)
-        if (*it == false) throw std::runtime_error(Animator::ERROR_MSG.c_str());
-
-    std::cout << "\x1B[2J\x1B[H";  // clears the screen
+    switch (lane)
+    {
+        case Direction::north: return southToNorth;
+        case Direction::south: return northToSouth;
+        case Direction::east:  return westToEast;
+        default:               return eastToWest;
+    }
+}
 
-    drawNorthPortion(time);
-    drawWestbound();
-    drawEastbound();
-    drawSouthPortion();
+//======================================================================
+//* Animator::put(const std::string& text)
+//======================================================================
+void Animator::put(const std::string& text)
+{
+    std::vector<Cell>& cells = skeleton.back().text;
+    for (size_t i = 0; i < text.size(); i++)
+        cells.push_back(Cell{text[i], STYLE_NONE});
+}
 
-    // reset the values (to false) in the boolean vector, indicating that the 
-    // user must set the vehicles in each of the four directions using the
-    // setVehicles* functions
-    vehiclesAreSet.clear();
-    vehiclesAreSet.resize(4);
+//======================================================================
+//* Animator::putSlot(Slot slot)
+//======================================================================
+void Animator::putSlot(Slot slot)
+{
+    skeleton.back().slot = slot;
+    skeleton.push_back(Piece{ {}, SLOT_NONE, Direction::north, 0, Direction::north, -1 });
 }
 
 //======================================================================
-//* std::string getVehicleColor(VehicleBase* vptr)
+//* Animator::putVehicle(Direction lane, int section, Direction otherLane, int otherSection)
 //======================================================================
-std::string Animator::getVehicleColor(VehicleBase* vptr)
+void Animator::putVehicle(Direction lane, int section, Direction otherLane, int otherSection)
 {
-    Direction dir = vptr->getVehicleOriginalDirection();
-    switch (vptr->getVehicleType())
-    {
-        case VehicleType::car: 
-            if (dir == Direction::east || dir == Direction::west)
-                return Animator::COLOR_RED_BG;
-            return Animator::COLOR_RED_FG;
-        case VehicleType::suv:
-            if (dir == Direction::east || dir == Direction::west)
-                return Animator::COLOR_BLUE_BG;
-            return Animator::COLOR_BLUE_FG;
-        case VehicleType::truck:
-            if (dir == Direction::east || dir == Direction::west)
-                return Animator::COLOR_GREEN_BG;
-            return Animator::COLOR_GREEN_FG;
-    }
-    return Animator::COLOR_RESET;
+    Piece& piece = skeleton.back();
+    piece.lane = lane;
+    piece.section = section;
+    piece.otherLane = otherLane;
+    piece.otherSection = otherSection;
+    putSlot(SLOT_VEHICLE);
 }
 
 //======================================================================
-//* ::string Animator::getTrafficLight(Direction direction)
+//* Animator::newLine()
 //======================================================================
-std::string Animator::getTrafficLight(Direction direction)
+void Animator::newLine()
 {
-    LightColor color = eastWestLightColor;
-    if (direction == Direction::north || direction == Direction::south)
-        color = northSouthLightColor;
+    putSlot(SLOT_END_OF_LINE);
+}
 
-    std::string light = "";
-    
+//======================================================================
+//* Animator::putTrafficLight(Direction direction)
+//======================================================================
+void Animator::putTrafficLight(Direction direction)
+{
     // when odd DIGITS_TO_DRAW, want the extra padding on left of lights
     // for the southbound and eastbound traffice
     if (direction == Direction::south || direction == Direction::east)
-        light += Animator::DIGITS_TO_DRAW % 2 == 0 ?
+        put(Animator::DIGITS_TO_DRAW % 2 == 0 ?
             std::string((Animator::DIGITS_TO_DRAW - 2) / 2, ' ') :
-            std::string((Animator::DIGITS_TO_DRAW - 1) / 2, ' ');
+            std::string((Animator::DIGITS_TO_DRAW - 1) / 2, ' '));
     else
-        light += std::string((Animator::DIGITS_TO_DRAW - 2) / 2, ' ');
+        put(std::string((Animator::DIGITS_TO_DRAW - 2) / 2, ' '));
+
+    if (direction == Direction::north || direction == Direction::south)
+        putSlot(SLOT_LIGHT_NORTH_SOUTH);
+    else
+        putSlot(SLOT_LIGHT_EAST_WEST);
 
-    switch (color)
-    {
-        case LightColor::green:  light += Animator::GREEN_LIGHT;  break;
-        case LightColor::yellow: light += Animator::YELLOW_LIGHT; break;
-        case LightColor::red:    light += Animator::RED_LIGHT;    break;
-    }
-    
     // when odd DIGITS_TO_DRAW, want the extra padding on right of lights
     // for the northbound and westbound traffice
     if (direction == Direction::south || direction == Direction::east)
-        light += std::string((Animator::DIGITS_TO_DRAW - 2) / 2, ' ');
+        put(std::string((Animator::DIGITS_TO_DRAW - 2) / 2, ' '));
     else
-        light += Animator::DIGITS_TO_DRAW % 2 == 0 ?
+        put(Animator::DIGITS_TO_DRAW % 2 == 0 ?
             std::string((Animator::DIGITS_TO_DRAW - 2) / 2, ' ') :
-            std::string((Animator::DIGITS_TO_DRAW - 1) / 2, ' ');
+            std::string((Animator::DIGITS_TO_DRAW - 1) / 2, ' '));
+}
 
-    return light;
+//======================================================================
+//* Animator::compose(int time)
+//======================================================================
+void Animator::compose(int time)
+{
+    frame.clear();
+    frameRowStart.clear();
+    frameRowStart.push_back(0);
+
+    for (size_t p = 0; p < skeleton.size(); p++)
+    {
+        const Piece& piece = skeleton[p];
+        frame.insert(frame.end(), piece.text.begin(), piece.text.end());
+
+        switch (piece.slot)
+        {
+            case SLOT_VEHICLE:
+            {
+                // either draw (a portion of) a vehicle, its ID zero-padded
+                // to the section width, or an empty section
+                VehicleBase* vptr = vehiclesFor(piece.lane)[piece.section];
+                if (vptr == nullptr && piece.otherSection >= 0)
+                    vptr = vehiclesFor(piece.otherLane)[piece.otherSection];
+                if (vptr == nullptr)
+                    frame.insert(frame.end(), emptySection.begin(), emptySection.end());
+                else
+                    appendNumber(vptr->getVehicleID(), Animator::DIGITS_TO_DRAW, getVehicleColor(vptr));
+                break;
+            }
+            case SLOT_LIGHT_NORTH_SOUTH:
+            case SLOT_LIGHT_EAST_WEST:
+            {
+                LightColor color = piece.slot == SLOT_LIGHT_NORTH_SOUTH ?
+                    northSouthLightColor : eastWestLightColor;
+                Style style = STYLE_NONE;
+                if (color == LightColor::green)  style = STYLE_GREEN_BG;
+                if (color == LightColor::yellow) style = STYLE_YELLOW_BG;
+                if (color == LightColor::red)    style = STYLE_RED_BG;
+                frame.push_back(Cell{' ', style});
+                frame.push_back(Cell{' ', style});
+                break;
+            }
+            case SLOT_TIME:
+                appendNumber(time, 0, STYLE_NONE);
+                break;
+            case SLOT_END_OF_LINE:
+                frameRowStart.push_back(frame.size());
+                break;
+            default:
+                break;
+        }
+    }
 }
 
 //======================================================================
-//* Animator::drawNorthPortion(int time)
+//* Animator::appendNumber(long value, int width, Style style)
 //======================================================================
-void Animator::drawNorthPortion(int time)
+void Animator::appendNumber(long value, int width, Style style)
+{
+    // zero-padded on the left to width, as setfill('0') and setw did
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* begin = formatDigits(value < 0 ? -static_cast<unsigned long>(value) : value, end);
+    if (value < 0) *--begin = '-';
+
+    for (int pad = width - static_cast<int>(end - begin); pad > 0; pad--)
+        frame.push_back(Cell{'0', style});
+    for (; begin < end; begin++)
+        frame.push_back(Cell{*begin, style});
+}
+
+//======================================================================
+//* Animator::appendStyled(const Cell& cell, uint8_t& currentStyle)
+//======================================================================
+void Animator::appendStyled(const Cell& cell, uint8_t& currentStyle)
+{
+    // the background styles set two attributes, so always go back to the
+    // default before switching to a different style
+    if (cell.style != currentStyle)
+    {
+        output += Animator::COLOR_RESET;
+        if (cell.style != STYLE_NONE)
+            output += *Animator::STYLE_CODES[cell.style];
+        currentStyle = cell.style;
+    }
+    output += cell.ch;
+}
+
+//======================================================================
+//* Animator::appendCursorMove(int row, int column)
+//======================================================================
+void Animator::appendCursorMove(int row, int column)
+{
+    // rows and columns are 0-based here, 1-based on the terminal
+    char digits[12];
+    char* end = digits + sizeof(digits);
+    output += "\x1B[";
+    output.append(formatDigits(row + 1, end), end);
+    output += ';';
+    output.append(formatDigits(column + 1, end), end);
+    output += 'H';
+}
+
+//======================================================================
+//* Animator::renderFull()
+//======================================================================
+void Animator::renderFull()
+{
+    output += "\x1B[2J\x1B[H";  // clears the screen
+
+    uint8_t style = STYLE_NONE;
+    for (size_t line = 0; line + 1 < frameRowStart.size(); line++)
+    {
+        for (int column = frameRowStart[line]; column < frameRowStart[line + 1]; column++)
+            appendStyled(frame[column], style);
+        if (style != STYLE_NONE)
+        {
+            output += Animator::COLOR_RESET;
+            style = STYLE_NONE;
+        }
+        output += '\n';
+    }
+}
+
+//======================================================================
+//* Animator::renderChanges()
+//======================================================================
+void Animator::renderChanges()
+{
+    // rewriting a few unchanged cells is cheaper than another cursor move
+    const int MAX_GAP = 4;
+
+    uint8_t style = STYLE_NONE;
+    int frameLines = frameRowStart.size() - 1;
+    int shownLines = shownRowStart.size() - 1;
+    for (int line = 0; line < std::max(frameLines, shownLines); line++)
+    {
+        const Cell* now = line < frameLines ? &frame[frameRowStart[line]] : nullptr;
+        int nowSize = line < frameLines ? frameRowStart[line + 1] - frameRowStart[line] : 0;
+        const Cell* before = line < shownLines ? &shown[shownRowStart[line]] : nullptr;
+        int beforeSize = line < shownLines ? shownRowStart[line + 1] - shownRowStart[line] : 0;
+
+        // most lines don't change at all from one tick to the next
+        if (nowSize == beforeSize && memcmp(now, before, nowSize * sizeof(Cell)) == 0)
+            continue;
+
+        int common = std::min(nowSize, beforeSize);
+        int column = 0;
+        while (column < common)
+        {
+            if (!(now[column] != before[column]))
+            {
+                column++;
+                continue;
+            }
+
+            // move to the first changed cell and write until the line stops
+            // changing for more than MAX_GAP cells
+            appendCursorMove(line, column);
+            int same = 0;
+            while (column < common && same <= MAX_GAP)
+            {
+                same = now[column] != before[column] ? 0 : same + 1;
+                appendStyled(now[column], style);
+                column++;
+            }
+        }
+
+        if (nowSize > common)
+        {
+            appendCursorMove(line, common);
+            for (column = common; column < nowSize; column++)
+                appendStyled(now[column], style);
+        }
+        else if (beforeSize > common)
+        {
+            // the line got shorter: erase what used to be past its end
+            if (style != STYLE_NONE)
+            {
+                output += Animator::COLOR_RESET;
+                style = STYLE_NONE;
+            }
+            appendCursorMove(line, common);
+            output += "\x1B[K";
+        }
+    }
+
+    if (style != STYLE_NONE)
+        output += Animator::COLOR_RESET;
+
+    // leave the cursor where a full redraw would, clearing anything echoed
+    // below the picture since the last frame
+    appendCursorMove(frameLines, 0);
+    output += "\x1B[J";
+}
+
+//======================================================================
+//* Animator::writeOutput()
+//======================================================================
+void Animator::writeOutput()
+{
+    // anything already buffered in std::cout belongs before this frame
+    std::cout.flush();
+
+    const char* next = output.data();
+    size_t left = output.size();
+    while (left > 0)
+    {
+        ssize_t written = write(STDOUT_FILENO, next, left);
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return;
+        }
+        next += written;
+        left -= written;
+    }
+}
+
+//======================================================================
+//* Animator::Style Animator::getVehicleColor(VehicleBase* vptr)
+//======================================================================
+Animator::Style Animator::getVehicleColor(VehicleBase* vptr)
+{
+    Direction dir = vptr->getVehicleOriginalDirection();
+    switch (vptr->getVehicleType())
+    {
+        case VehicleType::car:
+            if (dir == Direction::east || dir == Direction::west)
+                return STYLE_RED_BG;
+            return STYLE_RED_FG;
+        case VehicleType::suv:
+            if (dir == Direction::east || dir == Direction::west)
+                return STYLE_BLUE_BG;
+            return STYLE_BLUE_FG;
+        case VehicleType::truck:
+            if (dir == Direction::east || dir == Direction::west)
+                return STYLE_GREEN_BG;
+            return STYLE_GREEN_FG;
+    }
+    return STYLE_NONE;
+}
+
+//======================================================================
+//* Animator::drawNorthPortion()
+//======================================================================
+void Animator::drawNorthPortion()
 {
     for (int s = 0; s < numSectionsBefore; s++)
     {
         // draw empty spaces to account for E/W lanes to left of intersection
-        for (int i = 0; i < numSectionsBefore; i++) 
+        for (int i = 0; i < numSectionsBefore; i++)
+        {
+            if (i > 0) put(" ");
             if (s == numSectionsBefore - 1 && i == s)
-                std::cout << (i > 0 ? " " : "") 
-                          << getTrafficLight(Direction::south); // or north
+                putTrafficLight(Direction::south); // or north
             else
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
-
-        std::cout << Animator::SECTION_BOUNDARY_NS;
-
-        // either draw (a portion of) southbound vehicle if present, 
-        // or an empty section
-        if (northToSouth[s] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(northToSouth[s])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << northToSouth[s]->getVehicleID()
-                      << Animator::COLOR_RESET;
-
-        std::cout << Animator::SECTION_BOUNDARY_NS;
-
-        // either draw (a portion of) northbound vehicle if present, 
-        // or an empty section
-        int section = southToNorth.size() - s - 1;
-        if (southToNorth[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(southToNorth[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << southToNorth[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
-
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+                put(Animator::EMPTY_SECTION);
+        }
+
+        put(Animator::SECTION_BOUNDARY_NS);
+
+        // (a portion of) southbound vehicle if present, or an empty section
+        putVehicle(Direction::south, s);
+
+        put(Animator::SECTION_BOUNDARY_NS);
+
+        // (a portion of) northbound vehicle if present, or an empty section
+        int section = laneLength - s - 1;
+        putVehicle(Direction::north, section);
+
+        put(Animator::SECTION_BOUNDARY_NS);
 
         if (s == numSectionsBefore - 1)
-            std::cout << getTrafficLight(Direction::west);  // or east
+            putTrafficLight(Direction::west);  // or east
 
-        std::cout << std::endl;
+        newLine();
 
         if (s < numSectionsBefore - 1)  // last will be drawn by westbound method
         {
             // draw empty spaces to account for E/W lanes to left of intersection
-            for (int i = 0; i < numSectionsBefore; i++) 
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
-            std::cout << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW
-                      << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW 
-                      << Animator::SECTION_BOUNDARY_NS;
+            for (int i = 0; i < numSectionsBefore; i++)
+            {
+                if (i > 0) put(" ");
+                put(Animator::EMPTY_SECTION);
+            }
+            put(Animator::SECTION_BOUNDARY_NS);
+            put(Animator::SECTION_BOUNDARY_EW);
+            put(Animator::SECTION_BOUNDARY_NS);
+            put(Animator::SECTION_BOUNDARY_EW);
+            put(Animator::SECTION_BOUNDARY_NS);
         }
 
-        // draw the time halfway down, on right
-        if (s == numSectionsBefore / 2) 
-            std::cout << std::setfill(' ') 
-                << std::setw((numSectionsBefore / 2) * Animator::DIGITS_TO_DRAW)
-                << "time: " << time;
+        // draw the time halfway down, on right (the label right-aligned in a
+        // field the width of half the E/W sections, as setw used to do)
+        if (s == numSectionsBefore / 2)
+        {
+            std::string label = "time: ";
+            int width = (numSectionsBefore / 2) * Animator::DIGITS_TO_DRAW;
+            if (static_cast<int>(label.size()) < width)
+                put(std::string(width - label.size(), ' '));
+            put(label);
+            putSlot(SLOT_TIME);
+        }
 
-        if (s < numSectionsBefore - 1) std::cout << std::endl;
+        if (s < numSectionsBefore - 1) newLine();
     }
 }
 
@@ -247,13 +554,20 @@ void Animator::drawNorthPortion(int time)
 void Animator::drawEastWestBoundary()
 {
     for (int s = 0; s < numSectionsBefore; s++)
-        std::cout << Animator::SECTION_BOUNDARY_EW 
-            << (s == numSectionsBefore-1 ? Animator::SECTION_BOUNDARY_NS : " ");
-    std::cout << Animator::SECTION_BOUNDARY_EW << Animator::SECTION_BOUNDARY_NS;
-    std::cout << Animator::SECTION_BOUNDARY_EW << Animator::SECTION_BOUNDARY_NS;
+    {
+        put(Animator::SECTION_BOUNDARY_EW);
+        put(s == numSectionsBefore-1 ? Animator::SECTION_BOUNDARY_NS : " ");
+    }
+    put(Animator::SECTION_BOUNDARY_EW);
+    put(Animator::SECTION_BOUNDARY_NS);
+    put(Animator::SECTION_BOUNDARY_EW);
+    put(Animator::SECTION_BOUNDARY_NS);
     for (int s = 0; s < numSectionsBefore; s++)
-        std::cout << Animator::SECTION_BOUNDARY_EW << " ";
-    std::cout << std::endl;
+    {
+        put(Animator::SECTION_BOUNDARY_EW);
+        put(" ");
+    }
+    newLine();
 }
 
 //======================================================================
@@ -267,53 +581,28 @@ void Animator::drawEastbound()
     for (int s = 0; s < numSectionsBefore; s++)
     {
         int section = s;
-        if (westToEast[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION << "|";
-        else
-            std::cout << getVehicleColor(westToEast[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << westToEast[section]->getVehicleID()
-                      << Animator::COLOR_RESET << "|";
+        putVehicle(Direction::east, section);
+        put("|");
     }
 
     // now handle the intersection; the first spot in the west to east lane
     // could be occupied by a vehicle in the W2E lane or in the N2S lane
-    VehicleBase* vptr = (westToEast[numSectionsBefore] != nullptr ?
-            westToEast[numSectionsBefore] : northToSouth[numSectionsBefore + 1]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    putVehicle(Direction::east, numSectionsBefore, Direction::south, numSectionsBefore + 1);
+    put("|");
 
     // and the second spot in the west to east lane could be occupied by a
     // vehicle in the W2E lane or in the S2N lane
-    vptr = (westToEast[numSectionsBefore + 1] != nullptr ?
-            westToEast[numSectionsBefore + 1] : southToNorth[numSectionsBefore]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    putVehicle(Direction::east, numSectionsBefore + 1, Direction::north, numSectionsBefore);
+    put("|");
 
     // and now handle all the west-to-east sections after the intersection
-    for (int s = numSectionsBefore + 2; s < static_cast<int>(westToEast.size()); s++)
+    for (int s = numSectionsBefore + 2; s < laneLength; s++)
     {
         int section = s;
-        if (westToEast[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(westToEast[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << westToEast[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
-        std::cout << (s < static_cast<int>(westToEast.size()) - 1 ? "|" :  "");
+        putVehicle(Direction::east, section);
+        if (s < laneLength - 1) put("|");
     }
-    std::cout << std::endl;
+    newLine();
 
     drawEastWestBoundary();
 }
@@ -329,56 +618,31 @@ void Animator::drawWestbound()
     // (drawing in reverse order of the vector)
     for (int s = 0; s < numSectionsBefore; s++)
     {
-        int section = eastToWest.size() - s - 1;
-        if (eastToWest[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION << "|";
-        else
-            std::cout << getVehicleColor(eastToWest[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << eastToWest[section]->getVehicleID()
-                      << Animator::COLOR_RESET << "|";
+        int section = laneLength - s - 1;
+        putVehicle(Direction::west, section);
+        put("|");
     }
 
     // now handle the intersection; the first spot encountered L to R in the
     // east to west lane could be occupied by a vehicle in the E2W lane or in
     // the N2S lane
-    VehicleBase* vptr = (eastToWest[numSectionsBefore + 1] != nullptr ?
-            eastToWest[numSectionsBefore + 1] : northToSouth[numSectionsBefore]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    putVehicle(Direction::west, numSectionsBefore + 1, Direction::south, numSectionsBefore);
+    put("|");
 
     // and the second spot encountered L to R in the east to west lane could be
     // occupied by a vehicle in the E2W lane or in the S2N lane
-    vptr = (eastToWest[numSectionsBefore] != nullptr ?
-            eastToWest[numSectionsBefore] : southToNorth[numSectionsBefore + 1]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    putVehicle(Direction::west, numSectionsBefore, Direction::north, numSectionsBefore + 1);
+    put("|");
 
     // and now handle all the east-to-west sections after the intersection
     // (drawing in reverse order of the vector)
-    for (int s = numSectionsBefore + 2; s < static_cast<int>(eastToWest.size()); s++)
+    for (int s = numSectionsBefore + 2; s < laneLength; s++)
     {
-        int section = eastToWest.size() - s - 1;
-        if (eastToWest[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(eastToWest[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << eastToWest[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
-        std::cout << (s < static_cast<int>(eastToWest.size()) - 1 ? "|" :  "");
+        int section = laneLength - s - 1;
+        putVehicle(Direction::west, section);
+        if (s < laneLength - 1) put("|");
     }
-    std::cout << std::endl;
+    newLine();
 
 }
 
@@ -390,55 +654,49 @@ void Animator::drawSouthPortion()
     for (int s = 0; s < numSectionsBefore; s++)
     {
         // draw empty spaces to account for E/W lanes to left of intersection
-        for (int i = 0; i < numSectionsBefore; i++) 
+        for (int i = 0; i < numSectionsBefore; i++)
+        {
+            if (i > 0) put(" ");
             if (s == 0 && i == numSectionsBefore - 1)
-                std::cout << (i > 0 ? " " : "") 
-                          << getTrafficLight(Direction::east); // or west
+                putTrafficLight(Direction::east); // or west
             else
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
+                put(Animator::EMPTY_SECTION);
+        }
 
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        put(Animator::SECTION_BOUNDARY_NS);
 
-        // either draw (a portion of) southbound vehicle if present, 
-        // or an empty section
+        // (a portion of) southbound vehicle if present, or an empty section
         int section = numSectionsBefore + s + 2;
-        if (northToSouth[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(northToSouth[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << northToSouth[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
-
-        std::cout << Animator::SECTION_BOUNDARY_NS;
-
-        // either draw (a portion of) northbound vehicle if present, 
-        // or an empty section
+        putVehicle(Direction::south, section);
+
+        put(Animator::SECTION_BOUNDARY_NS);
+
+        // (a portion of) northbound vehicle if present, or an empty section
         section = numSectionsBefore - s - 1;
-        if (southToNorth[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(southToNorth[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << southToNorth[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
+        putVehicle(Direction::north, section);
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        put(Animator::SECTION_BOUNDARY_NS);
 
         if (s == 0)
-            std::cout << getTrafficLight(Direction::north);  // or south
-            
-        std::cout << std::endl;
+            putTrafficLight(Direction::north);  // or south
+
+        newLine();
 
         if (s < numSectionsBefore - 1)  // no need to draw last section spacer
         {
             // draw empty spaces to account for E/W lanes to left of intersection
-            for (int i = 0; i < numSectionsBefore; i++) 
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
-            std::cout << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW
-                      << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW 
-                      << Animator::SECTION_BOUNDARY_NS << std::endl;
+            for (int i = 0; i < numSectionsBefore; i++)
+            {
+                if (i > 0) put(" ");
+                put(Animator::EMPTY_SECTION);
+            }
+            put(Animator::SECTION_BOUNDARY_NS);
+            put(Animator::SECTION_BOUNDARY_EW);
+            put(Animator::SECTION_BOUNDARY_NS);
+            put(Animator::SECTION_BOUNDARY_EW);
+            put(Animator::SECTION_BOUNDARY_NS);
+            newLine();
         }
 
     }
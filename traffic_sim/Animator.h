@@ -1,8 +1,10 @@
 #ifndef __ANIMATOR_H__
 #define __ANIMATOR_H__
 
+#include <cstdint>
 #include <string>
 #include <vector>
+#include "LaneVehicles.h"
 #include "VehicleBase.h"
 
 //==========================================================================
@@ -51,6 +53,33 @@
 //*     foreground
 //*   - added capability for traffic lights display (north/south lights are 
 //*     identical, as are east/west lights)
+//*
+//* Modifications for differential rendering:
+//*   - each frame is drawn into an in-memory grid of character cells (each
+//*     with a color style) rather than straight to std::cout
+//*   - draw() compares the grid with the previous frame's and only moves
+//*     the cursor to, and rewrites, the cells that changed; the screen is
+//*     cleared and fully redrawn on the first frame, whenever the terminal
+//*     is resized, and every frame when the picture doesn't fit in the
+//*     terminal with a line to spare (pressing Enter would scroll it)
+//*
+//* Modifications for single-buffer frame composition:
+//*   - the draw* methods run once, in the constructor, and record the
+//*     picture as a skeleton: runs of fixed text (boundaries, padding, the
+//*     "time: " label) separated by slots for the parts that change (vehicle
+//*     sections, the two lights, the clock)
+//*   - draw() copies the skeleton into a preallocated cell buffer, fills in
+//*     the slots (vehicle IDs are formatted without iostreams), and sends
+//*     the escape sequences for the frame to the terminal in one write call
+//*
+//* Modifications for zero-copy lane views:
+//*   - the setVehicles* functions take a LaneVehicles, a non-owning view
+//*     of a lane, instead of copying a std::vector<VehicleBase*>; a view
+//*     can wrap such a vector or look the vehicles up in whatever storage
+//*     the simulation keeps them in (see Lane::animatorView), so setting
+//*     the lanes and drawing a frame neither allocates nor copies
+//*   - the storage a view refers to must stay unchanged until draw() has
+//*     been called
 //==========================================================================
 
 class Animator
@@ -72,18 +101,74 @@ class Animator
       static const std::string COLOR_YELLOW_BG;
       static const std::string COLOR_RESET;
 
-      static std::string GREEN_LIGHT;
-      static std::string YELLOW_LIGHT;
-      static std::string RED_LIGHT;
-
-      std::vector<bool> vehiclesAreSet;  // 0:north 1:west 2:south 3:east
+      // color styles a cell can be drawn in; STYLE_CODES[style] is the escape
+      // sequence that selects it (STYLE_NONE is the terminal default)
+      enum Style : uint8_t { STYLE_NONE, STYLE_RED_FG, STYLE_GREEN_FG, STYLE_BLUE_FG,
+                             STYLE_RED_BG, STYLE_GREEN_BG, STYLE_BLUE_BG, STYLE_YELLOW_BG };
+      static const std::string* const STYLE_CODES[];
+
+      struct Cell
+      {
+         char    ch;
+         uint8_t style;
+
+         inline bool operator!=(const Cell& other) const
+               { return ch != other.ch || style != other.style; }
+      };
+
+      // what fills the gap after a run of fixed text in the skeleton
+      enum Slot : uint8_t { SLOT_NONE, SLOT_VEHICLE, SLOT_LIGHT_NORTH_SOUTH,
+                            SLOT_LIGHT_EAST_WEST, SLOT_TIME, SLOT_END_OF_LINE };
+
+      struct Piece
+      {
+         std::vector<Cell> text;  // fixed text, drawn as is
+         Slot slot;
+         Direction lane;          // SLOT_VEHICLE: the section drawn, and in the
+         int section;             // intersection the crossing lane's section
+         Direction otherLane;     // drawn when the first is empty (otherSection
+         int otherSection;        // is -1 everywhere else)
+      };
+
+      bool vehiclesAreSet[4];  // 0:north 1:west 2:south 3:east
       int numSectionsBefore;
-
-      std::string getVehicleColor(VehicleBase* vptr);
-      std::string createLight(LightColor color);
-      std::string getTrafficLight(Direction direction);
-
-      void drawNorthPortion(int time);
+      int laneLength;          // sections in each lane
+
+      std::vector<Piece> skeleton;
+      std::vector<Cell> emptySection;
+
+      // the frame being drawn and the one currently on the terminal; line i
+      // of a frame is cells [rowStart[i], rowStart[i + 1])
+      std::vector<Cell> frame;
+      std::vector<int> frameRowStart;
+      std::vector<Cell> shown;
+      std::vector<int> shownRowStart;
+      bool shownIsValid;       // false until the first frame has been drawn
+      int terminalRows;        // terminal size when the last frame was drawn
+      int terminalColumns;     // (0 if unknown, e.g. output is not a terminal)
+      std::string output;      // escape sequences and text for one frame
+
+      Style getVehicleColor(VehicleBase* vptr);
+      const LaneVehicles& vehiclesFor(Direction lane) const;
+
+      // building the skeleton
+      void put(const std::string& text);
+      void putSlot(Slot slot);
+      void putVehicle(Direction lane, int section,
+                      Direction otherLane = Direction::north, int otherSection = -1);
+      void putTrafficLight(Direction direction);
+      void newLine();
+
+      // drawing a frame
+      void compose(int time);
+      void appendNumber(long value, int width, Style style);
+      void appendStyled(const Cell& cell, uint8_t& currentStyle);
+      void appendCursorMove(int row, int column);
+      void renderFull();
+      void renderChanges();
+      void writeOutput();
+
+      void drawNorthPortion();
       void drawEastbound();
       void drawEastWestBoundary();
       void drawWestbound();
@@ -92,10 +177,10 @@ class Animator
       LightColor northSouthLightColor;
       LightColor eastWestLightColor;
 
-      std::vector<VehicleBase*> eastToWest;
-      std::vector<VehicleBase*> westToEast;
-      std::vector<VehicleBase*> northToSouth;
-      std::vector<VehicleBase*> southToNorth;
+      LaneVehicles eastToWest;
+      LaneVehicles westToEast;
+      LaneVehicles northToSouth;
+      LaneVehicles southToNorth;
 
    public:
       static int MAX_VEHICLE_COUNT;
@@ -108,13 +193,13 @@ class Animator
       inline void setLightEastWest(LightColor color)
             { eastWestLightColor = color; }
 
-      inline void setVehiclesNorthbound(std::vector<VehicleBase*> vehicles)
+      inline void setVehiclesNorthbound(LaneVehicles vehicles)
             { southToNorth = vehicles;  vehiclesAreSet[0] = true; }
-      inline void setVehiclesWestbound(std::vector<VehicleBase*> vehicles)
+      inline void setVehiclesWestbound(LaneVehicles vehicles)
             { eastToWest   = vehicles;  vehiclesAreSet[1] = true; }
-      inline void setVehiclesSouthbound(std::vector<VehicleBase*> vehicles)
+      inline void setVehiclesSouthbound(LaneVehicles vehicles)
             { northToSouth = vehicles;  vehiclesAreSet[2] = true; }
-      inline void setVehiclesEastbound(std::vector<VehicleBase*> vehicles)
+      inline void setVehiclesEastbound(LaneVehicles vehicles)
             { westToEast   = vehicles;  vehiclesAreSet[3] = true; }
 
 
@@ -0,0 +1,343 @@
+// Microbenchmarks for the per-tick kernels of an intersection and for the
+// Animator, printed as JSON so results can be compared from run to run.
+//
+// Usage: ./bench [input file] [--repetitions R] [--ticks T] [--sizes a,b,...]
+//
+// Each kernel is timed where it really runs: a batch of independent
+// intersections (different seeds) is warmed up to steady state, then every
+// repetition steps them T more ticks in lockstep, phase by phase exactly as
+// Intersection::step does, with one clock read before and after the target
+// kernel's phase across the whole batch. That keeps the clock's cost (which
+// is measured up front and subtracted) small next to the hundreds of calls
+// it covers. A repetition gives one ns/op figure (an op is one call, e.g.
+// movePassed on one lane) and the report gives the median and spread of
+// those figures.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "Animator.h"
+#include "Config.h"
+#include "Intersection.h"
+
+using namespace::std;
+
+typedef chrono::steady_clock Clock;
+
+// the parts of a tick, in the order Intersection::step runs them
+enum class Phase { movePassed, moveThrough, movePre, updateLights, generate, loadVehicles };
+const int PHASES = 6;
+
+// Intersection grants this class access to its private kernels
+class IntersectionBench
+{
+   public:
+      // run one phase of a tick of Intersection::step (same calls, same
+      // order) and return how many kernel calls it made; newVehicles carries
+      // generate's result over to loadVehicles
+      static int runPhase(Intersection& x, int tick, Phase phase, std::array<VehicleType, 4>& newVehicles);
+
+   private:
+      // runPhase with the lane kernels step() dispatches to for this geometry
+      template <int SECTIONS>
+      static int runPhaseWith(Intersection& x, int tick, Phase phase, std::array<VehicleType, 4>& newVehicles);
+};
+
+// one line of the report
+struct BenchResult
+{
+    string name;
+    string scenario;
+    int sections;
+    long opsPerRepetition;
+    vector<double> nsPerOp; // one per repetition
+};
+
+// method prototypes:
+double timerOverhead();
+BenchResult benchKernel(const SimulationConfig& config, const string& scenario, Phase kernel, const string& name);
+BenchResult benchDraw(const SimulationConfig& config, const string& scenario);
+double percentile(vector<double> values, double fraction);
+void printJson(const vector<BenchResult>& results);
+
+// run settings (from the command line)
+int repetitions = 25;
+int ticksPerRepetition = 200;
+int warmupTicks = 2000;
+int batchSize = 32;    // intersections stepped side by side
+double overheadNs = 0; // cost of one pair of clock reads, subtracted from every timed region
+
+int main(int argc, char* argv[])
+{
+    string inputFile = "sample1";
+    vector<int> sizes = {3, 9, 30, 100};
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--repetitions") == 0 && arg + 1 < argc)
+            repetitions = max(1, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--ticks") == 0 && arg + 1 < argc)
+            ticksPerRepetition = max(1, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--sizes") == 0 && arg + 1 < argc)
+        {
+            sizes.clear();
+            for (char* size = strtok(argv[++arg], ","); size != nullptr; size = strtok(nullptr, ","))
+                sizes.push_back(max(2, atoi(size)));
+        }
+        else if (argv[arg][0] != '-')
+            inputFile = argv[arg];
+        else
+        {
+            cerr << "Usage: " << argv[0] << " [input file] [--repetitions R] [--ticks T] [--sizes a,b,...]" << endl;
+            exit(0);
+        }
+    }
+
+    map<string, double> input_dict = readKeyValueFile(inputFile);
+    SimulationConfig base = makeConfig(input_dict);
+    overheadNs = timerOverhead();
+
+    vector<BenchResult> results;
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        SimulationConfig config = base;
+        config.number_of_sections_before_intersection = sizes[s];
+
+        // no turns at all, most vehicles turning left (so the gap check runs
+        // all the time), and every approach generating a vehicle whenever it can
+        SimulationConfig straight = config;
+        straight.proportion_right_turn_cars = straight.proportion_left_turn_cars = 0;
+        straight.proportion_right_turn_SUVs = straight.proportion_left_turn_SUVs = 0;
+        straight.proportion_right_turn_trucks = straight.proportion_left_turn_trucks = 0;
+        SimulationConfig leftHeavy = config;
+        leftHeavy.proportion_right_turn_cars = leftHeavy.proportion_right_turn_SUVs = leftHeavy.proportion_right_turn_trucks = 0.1;
+        leftHeavy.proportion_left_turn_cars = leftHeavy.proportion_left_turn_SUVs = leftHeavy.proportion_left_turn_trucks = 0.7;
+        SimulationConfig saturated = config;
+        saturated.prob_new_vehicle_northbound = saturated.prob_new_vehicle_southbound = 1;
+        saturated.prob_new_vehicle_eastbound = saturated.prob_new_vehicle_westbound = 1;
+
+        results.push_back(benchKernel(config, "input", Phase::movePassed, "movePassed"));
+        results.push_back(benchKernel(config, "input", Phase::movePre, "movePre"));
+        results.push_back(benchKernel(straight, "straight_only", Phase::moveThrough, "moveThrough"));
+        results.push_back(benchKernel(leftHeavy, "left_heavy", Phase::moveThrough, "moveThrough"));
+        results.push_back(benchKernel(saturated, "saturated", Phase::moveThrough, "moveThrough"));
+        results.push_back(benchKernel(config, "input", Phase::generate, "generate"));
+        results.push_back(benchKernel(config, "input", Phase::loadVehicles, "loadVehicles"));
+        results.push_back(benchDraw(config, "input"));
+    }
+
+    printJson(results);
+}
+
+int IntersectionBench::runPhase(Intersection& x, int tick, Phase phase, array<VehicleType, 4>& newVehicles)
+{
+    return Intersection::withSectionCount(x.num_sec, [&](auto sections)
+        { return runPhaseWith<decltype(sections)::value>(x, tick, phase, newVehicles); });
+}
+
+template <int SECTIONS>
+int IntersectionBench::runPhaseWith(Intersection& x, int tick, Phase phase, array<VehicleType, 4>& newVehicles)
+{
+    Lane& northbound = x.lanes[static_cast<int>(Direction::north)];
+    Lane& southbound = x.lanes[static_cast<int>(Direction::south)];
+    Lane& eastbound = x.lanes[static_cast<int>(Direction::east)];
+    Lane& westbound = x.lanes[static_cast<int>(Direction::west)];
+
+    switch (phase)
+    {
+        case Phase::movePassed:
+            x.movePassed<SECTIONS>(northbound, Direction::north, tick);
+            x.movePassed<SECTIONS>(southbound, Direction::south, tick);
+            x.movePassed<SECTIONS>(eastbound, Direction::east, tick);
+            x.movePassed<SECTIONS>(westbound, Direction::west, tick);
+            return 4;
+        case Phase::moveThrough:
+            if (x.goEW == true)
+            {
+                x.moveThrough<SECTIONS>(eastbound, southbound, northbound, westbound, x.currentEW);
+                x.moveThrough<SECTIONS>(westbound, northbound, southbound, eastbound, x.currentEW);
+            }
+            else
+            {
+                x.moveThrough<SECTIONS>(northbound, eastbound, westbound, southbound, x.currentNS);
+                x.moveThrough<SECTIONS>(southbound, westbound, eastbound, northbound, x.currentNS);
+            }
+            return 2;
+        case Phase::movePre:
+            x.movePre<SECTIONS>(northbound);
+            x.movePre<SECTIONS>(southbound);
+            x.movePre<SECTIONS>(eastbound);
+            x.movePre<SECTIONS>(westbound);
+            return 4;
+        case Phase::updateLights:
+            x.updateLights();
+            return 1;
+        case Phase::generate:
+            newVehicles = x.generate(tick);
+            return 1;
+        case Phase::loadVehicles:
+            x.loadVehicles(newVehicles, northbound, Direction::north, tick);
+            x.loadVehicles(newVehicles, southbound, Direction::south, tick);
+            x.loadVehicles(newVehicles, eastbound, Direction::east, tick);
+            x.loadVehicles(newVehicles, westbound, Direction::west, tick);
+            return 4;
+    }
+    return 0;
+}
+
+double timerOverhead()
+{
+    // median cost of an empty timed region
+    const int PAIRS = 100000;
+    vector<double> samples;
+    for (int r = 0; r < 25; r++)
+    {
+        Clock::duration elapsed(0);
+        for (int i = 0; i < PAIRS; i++)
+        {
+            Clock::time_point start = Clock::now();
+            elapsed += Clock::now() - start;
+        }
+        samples.push_back(chrono::duration<double, nano>(elapsed).count() / PAIRS);
+    }
+    return percentile(samples, 0.5);
+}
+
+BenchResult benchKernel(const SimulationConfig& config, const string& scenario, Phase kernel, const string& name)
+{
+    SignalTiming timing = {config.green_north_south, config.yellow_north_south,
+                           config.green_east_west, config.yellow_east_west};
+    vector<unique_ptr<Intersection>> batch;
+    for (int k = 0; k < batchSize; k++)
+        batch.emplace_back(new Intersection(config, timing, 0, 1, k + 1));
+    vector<array<VehicleType, 4>> newVehicles(batchSize);
+
+    // warm up: fill the lanes and the vehicle tables, and the caches
+    int tick = 0;
+    for (; tick < warmupTicks; tick++)
+        for (int k = 0; k < batchSize; k++)
+            batch[k]->step(tick);
+
+    BenchResult result = {name, scenario, config.number_of_sections_before_intersection, 0, {}};
+    for (int r = 0; r < repetitions; r++)
+    {
+        Clock::duration elapsed(0);
+        long ops = 0;
+        long regions = 0;
+        for (int t = 0; t < ticksPerRepetition; t++, tick++)
+        {
+            for (int p = 0; p < PHASES; p++)
+            {
+                Phase phase = static_cast<Phase>(p);
+                if (phase != kernel)
+                {
+                    for (int k = 0; k < batchSize; k++)
+                        IntersectionBench::runPhase(*batch[k], tick, phase, newVehicles[k]);
+                    continue;
+                }
+
+                Clock::time_point start = Clock::now();
+                for (int k = 0; k < batchSize; k++)
+                    ops += IntersectionBench::runPhase(*batch[k], tick, phase, newVehicles[k]);
+                elapsed += Clock::now() - start;
+                regions++;
+            }
+        }
+
+        double ns = chrono::duration<double, nano>(elapsed).count() - overheadNs * regions;
+        result.nsPerOp.push_back(max(0.0, ns) / ops);
+        result.opsPerRepetition = ops;
+    }
+    return result;
+}
+
+BenchResult benchDraw(const SimulationConfig& config, const string& scenario)
+{
+    SignalTiming timing = {config.green_north_south, config.yellow_north_south,
+                           config.green_east_west, config.yellow_east_west};
+    Intersection x(config, timing, 0, 1, 1);
+    int tick = 0;
+    for (; tick < warmupTicks; tick++)
+        x.step(tick);
+
+    // the frames go to /dev/null instead of into the JSON on stdout
+    fflush(stdout);
+    cout.flush();
+    int savedStdout = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+
+    Animator animator(config.number_of_sections_before_intersection);
+    BenchResult result = {"Animator::draw", scenario, config.number_of_sections_before_intersection, 0, {}};
+    for (int r = -1; r < repetitions; r++) // repetition -1 is warmup (and the first, full, redraw)
+    {
+        Clock::duration elapsed(0);
+        long ops = 0;
+        for (int t = 0; t < ticksPerRepetition; t++, tick++)
+        {
+            x.step(tick);
+            animator.setLightNorthSouth(x.getLightNorthSouth());
+            animator.setLightEastWest(x.getLightEastWest());
+            animator.setVehiclesNorthbound(x.getLane(Direction::north).animatorView(x.getVehicles()));
+            animator.setVehiclesWestbound(x.getLane(Direction::west).animatorView(x.getVehicles()));
+            animator.setVehiclesSouthbound(x.getLane(Direction::south).animatorView(x.getVehicles()));
+            animator.setVehiclesEastbound(x.getLane(Direction::east).animatorView(x.getVehicles()));
+
+            Clock::time_point start = Clock::now();
+            animator.draw(tick);
+            elapsed += Clock::now() - start;
+            ops++;
+        }
+        if (r >= 0)
+        {
+            double ns = chrono::duration<double, nano>(elapsed).count() - overheadNs * ops;
+            result.nsPerOp.push_back(max(0.0, ns) / ops);
+            result.opsPerRepetition = ops;
+        }
+    }
+
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    return result;
+}
+
+double percentile(vector<double> values, double fraction)
+{
+    // nearest rank
+    sort(values.begin(), values.end());
+    int rank = static_cast<int>(fraction * (values.size() - 1) + 0.5);
+    return values[rank];
+}
+
+void printJson(const vector<BenchResult>& results)
+{
+    printf("{\n");
+    printf("  \"repetitions\": %d,\n", repetitions);
+    printf("  \"ticks_per_repetition\": %d,\n", ticksPerRepetition);
+    printf("  \"warmup_ticks\": %d,\n", warmupTicks);
+    printf("  \"batch_size\": %d,\n", batchSize);
+    printf("  \"timer_overhead_ns\": %.2f,\n", overheadNs);
+    printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& result = results[i];
+        printf("    {\"name\": \"%s\", \"scenario\": \"%s\", \"sections\": %d, \"ops_per_repetition\": %ld, "
+               "\"ns_per_op\": {\"median\": %.2f, \"p5\": %.2f, \"p95\": %.2f, \"min\": %.2f, \"max\": %.2f}}%s\n",
+               result.name.c_str(), result.scenario.c_str(), result.sections, result.opsPerRepetition,
+               percentile(result.nsPerOp, 0.5), percentile(result.nsPerOp, 0.05), percentile(result.nsPerOp, 0.95),
+               percentile(result.nsPerOp, 0), percentile(result.nsPerOp, 1),
+               i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
@@ -0,0 +1,232 @@
+#ifndef __CHECKPOINT_CPP__
+#define __CHECKPOINT_CPP__
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "Checkpoint.h"
+#include "Varint.h"
+
+using namespace::std;
+
+static const char MAGIC[] = "TSCHECK1";
+static const size_t MAGIC_LENGTH = 8;
+
+static uint32_t fnv1a(const uint8_t* data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void CheckpointWriter::put8(uint8_t value)
+{
+    payload.push_back(value);
+}
+
+void CheckpointWriter::put32(uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        payload.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void CheckpointWriter::put64(uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        payload.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void CheckpointWriter::putDouble(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put64(bits);
+}
+
+void CheckpointWriter::putVarint(uint64_t value)
+{
+    ::putVarint(payload, value);
+}
+
+void CheckpointWriter::putBytes(const vector<uint8_t>& values)
+{
+    put32(values.size());
+    payload.insert(payload.end(), values.begin(), values.end());
+}
+
+void CheckpointWriter::putWords(const vector<uint32_t>& values)
+{
+    put32(values.size());
+    for (uint32_t value : values)
+        put32(value);
+}
+
+void CheckpointWriter::putVarints(const vector<uint64_t>& values)
+{
+    put32(values.size());
+    for (uint64_t value : values)
+        putVarint(value);
+}
+
+void CheckpointWriter::write(const string& fileName) const
+{
+    // header and footer around the payload
+    CheckpointWriter framing;
+    framing.put32(VERSION);
+    framing.put64(payload.size());
+    CheckpointWriter footer;
+    footer.put32(fnv1a(payload.data(), payload.size()));
+
+    string temporary = fileName + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+    {
+        cerr << "Could not write checkpoint " << temporary << endl;
+        exit(0);
+    }
+    bool written = fwrite(MAGIC, 1, MAGIC_LENGTH, file) == MAGIC_LENGTH
+        && fwrite(framing.payload.data(), 1, framing.payload.size(), file) == framing.payload.size()
+        && fwrite(payload.data(), 1, payload.size(), file) == payload.size()
+        && fwrite(footer.payload.data(), 1, footer.payload.size(), file) == footer.payload.size();
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporary.c_str(), fileName.c_str()) != 0)
+    {
+        cerr << "Could not write checkpoint " << fileName << endl;
+        exit(0);
+    }
+}
+
+CheckpointReader::CheckpointReader(const string& fileName) : fileName(fileName), position(0)
+{
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        cerr << "Could not open checkpoint " << fileName << endl;
+        exit(0);
+    }
+    vector<uint8_t> contents;
+    uint8_t block[65536];
+    size_t got;
+    while ((got = fread(block, 1, sizeof(block), file)) > 0)
+        contents.insert(contents.end(), block, block + got);
+    fclose(file);
+
+    // header, then check the payload against the footer's hash
+    const size_t HEADER = MAGIC_LENGTH + 4 + 8;
+    if (contents.size() < HEADER + 4 || memcmp(contents.data(), MAGIC, MAGIC_LENGTH) != 0)
+        fail("not a checkpoint");
+    payload.assign(contents.begin() + MAGIC_LENGTH, contents.begin() + HEADER);
+    uint32_t version = get32();
+    uint64_t length = get64();
+    if (version != CheckpointWriter::VERSION)
+        fail("version " + to_string(version) + " (this build reads version " + to_string(CheckpointWriter::VERSION) + ")");
+    if (length != contents.size() - HEADER - 4)
+        fail("truncated");
+
+    const uint8_t* footer = contents.data() + contents.size() - 4;
+    uint32_t hash = footer[0] | footer[1] << 8 | footer[2] << 16 | static_cast<uint32_t>(footer[3]) << 24;
+    payload.assign(contents.begin() + HEADER, contents.end() - 4);
+    position = 0;
+    if (hash != fnv1a(payload.data(), payload.size()))
+        fail("damaged (checksum mismatch)");
+}
+
+CheckpointReader::CheckpointReader(const vector<uint8_t>& payload, const string& name)
+    : fileName(name), payload(payload), position(0)
+{
+
+}
+
+void CheckpointReader::fail(const string& reason) const
+{
+    cerr << "Cannot resume from checkpoint " << fileName << ": " << reason << endl;
+    exit(0);
+}
+
+const uint8_t* CheckpointReader::take(size_t bytes)
+{
+    if (payload.size() - position < bytes)
+        fail("truncated");
+    const uint8_t* p = payload.data() + position;
+    position += bytes;
+    return p;
+}
+
+uint8_t CheckpointReader::get8()
+{
+    return *take(1);
+}
+
+uint32_t CheckpointReader::get32()
+{
+    const uint8_t* p = take(4);
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return value;
+}
+
+uint64_t CheckpointReader::get64()
+{
+    const uint8_t* p = take(8);
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return value;
+}
+
+double CheckpointReader::getDouble()
+{
+    uint64_t bits = get64();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint64_t CheckpointReader::getVarint()
+{
+    // the last byte of a varint (at most ten) has its high bit clear
+    size_t end = position;
+    while (end < payload.size() && end - position < 9 && (payload[end] & 0x80))
+        end++;
+    const uint8_t* p = take(end - position + 1);
+    if (p[end - position] & 0x80)
+        fail("bad varint");
+    return ::getVarint(p);
+}
+
+vector<uint8_t> CheckpointReader::getBytes()
+{
+    uint32_t length = get32();
+    const uint8_t* p = take(length);
+    return vector<uint8_t>(p, p + length);
+}
+
+vector<uint32_t> CheckpointReader::getWords()
+{
+    uint32_t length = get32();
+    if ((payload.size() - position) / 4 < length)
+        fail("truncated");
+    vector<uint32_t> values(length);
+    for (uint32_t i = 0; i < length; i++)
+        values[i] = get32();
+    return values;
+}
+
+vector<uint64_t> CheckpointReader::getVarints()
+{
+    uint32_t length = get32();
+    if (payload.size() - position < length) // every varint takes at least a byte
+        fail("truncated");
+    vector<uint64_t> values(length);
+    for (uint32_t i = 0; i < length; i++)
+        values[i] = getVarint();
+    return values;
+}
+
+#endif
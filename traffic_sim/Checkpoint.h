@@ -0,0 +1,78 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Checkpoint file layout (all integers little endian):
+//    header:   "TSCHECK1", u32 version, u64 payload length
+//    payload:  the state of a SimulationRun (see SimulationRun::save):
+//              the config and seed it was started with, the clock, then
+//              every intersection's lanes, lights, vehicle table, random
+//              number stream and statistics
+//    footer:   u32 FNV-1a hash of the payload
+// Integers are fixed width, or LEB128 varints where most are small (the
+// vehicle IDs, and the buckets of the trip time histograms, stored
+// sparsely), doubles are stored as their 64-bit pattern and vectors as a
+// u32 length followed by the elements, so the payload is plain binary with
+// no padding. A reader refuses files with the wrong magic or version, a
+// short payload or a bad hash (e.g. a checkpoint cut off by a crash),
+// rather than resuming from a damaged state.
+
+// Builds a checkpoint in memory; write() puts it on disk.
+class CheckpointWriter
+{
+   private:
+      std::vector<uint8_t> payload;
+
+   public:
+      static const uint32_t VERSION = 4;
+
+      void put8(uint8_t value);
+      void put32(uint32_t value);
+      void put64(uint64_t value);
+      void putDouble(double value);
+      void putVarint(uint64_t value);
+      void putBytes(const std::vector<uint8_t>& values);    // u32 length, then the bytes
+      void putWords(const std::vector<uint32_t>& values);   // u32 length, then the words
+      void putVarints(const std::vector<uint64_t>& values); // u32 length, then each as a varint
+
+      inline const std::vector<uint8_t>& getPayload() const { return payload; }
+
+      // write the checkpoint to fileName.tmp and rename it over fileName, so
+      // a crash while writing leaves the previous checkpoint intact
+      void write(const std::string& fileName) const;
+};
+
+// Reads back what a CheckpointWriter wrote, in the same order; exits with
+// a message if the file is missing, damaged or runs out early.
+class CheckpointReader
+{
+   private:
+      std::string fileName;
+      std::vector<uint8_t> payload;
+      size_t position;
+
+      const uint8_t* take(size_t bytes);
+
+   public:
+      CheckpointReader(const std::string& fileName);
+      // read a payload kept in memory (name is used in error messages)
+      CheckpointReader(const std::vector<uint8_t>& payload, const std::string& name);
+
+      uint8_t get8();
+      uint32_t get32();
+      uint64_t get64();
+      double getDouble();
+      uint64_t getVarint();
+      std::vector<uint8_t> getBytes();
+      std::vector<uint32_t> getWords();
+      std::vector<uint64_t> getVarints();
+
+      // exit with a message naming the file if the state read doesn't fit
+      // the run being resumed
+      void fail(const std::string& reason) const;
+};
+
+#endif
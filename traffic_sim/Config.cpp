@@ -0,0 +1,85 @@
+#ifndef __CONFIG_CPP__
+#define __CONFIG_CPP__
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include "Config.h"
+
+using namespace::std;
+
+map<string, double> readKeyValueFile(const string& fileName)
+{
+    // ensures the input file opens correctly
+    ifstream infile {fileName};
+    if (!infile)
+    {
+        cerr << "Unable to open file: " << fileName << endl;
+        exit(0);
+    }
+
+    // create input dictionary to store input variables
+    map<string, double> input_dict;
+    string line;
+    string input_spec;
+    double input_value;
+
+    // read input line by line regardless of order and whitespace
+    bool colonFound = false;
+    int i = 0;
+    while (getline(infile, line))
+    {
+        // remove spaces from line, skip blank lines (length == 0)
+        line.erase(std::remove_if(line.begin(), line.end(), [](char c) { return std::isspace(c); }), line.end());
+        if (line.length() != 0)
+        {
+            while(!colonFound)
+            {
+                // iterate through the line until colon is found, then set input_spec equal to all non-ws characters before colon and 
+                // input_value equal to all non-ws characters after colon and then add key-value pair to the input dictionary
+                if (line[i] == ':')
+                {
+                    colonFound = true;
+                    input_spec = line.substr(0, i);
+                    input_value = stod(line.substr(i+1,line.length() - 1));
+                    input_dict[input_spec] = input_value;
+                }
+                i++;
+            }
+            colonFound = false;
+            i = 0;
+        }
+    }
+
+    infile.close(); // close input file
+    return input_dict;
+}
+
+SimulationConfig makeConfig(map<string, double>& input_dict)
+{
+    SimulationConfig config;
+    config.maximum_simulated_time = input_dict["maximum_simulated_time"];
+    config.number_of_sections_before_intersection = input_dict["number_of_sections_before_intersection"];
+    config.green_north_south = input_dict["green_north_south"];
+    config.yellow_north_south = input_dict["yellow_north_south"];
+    config.green_east_west = input_dict["green_east_west"];
+    config.yellow_east_west = input_dict["yellow_east_west"];
+    config.prob_new_vehicle_northbound = input_dict["prob_new_vehicle_northbound"];
+    config.prob_new_vehicle_southbound = input_dict["prob_new_vehicle_southbound"];
+    config.prob_new_vehicle_eastbound = input_dict["prob_new_vehicle_eastbound"];
+    config.prob_new_vehicle_westbound = input_dict["prob_new_vehicle_westbound"];
+    config.proportion_of_cars = input_dict["proportion_of_cars"];
+    config.proportion_of_SUVs = input_dict["proportion_of_SUVs"];
+    config.proportion_right_turn_cars = input_dict["proportion_right_turn_cars"];
+    config.proportion_left_turn_cars = input_dict["proportion_left_turn_cars"];
+    config.proportion_right_turn_SUVs = input_dict["proportion_right_turn_SUVs"];
+    config.proportion_left_turn_SUVs = input_dict["proportion_left_turn_SUVs"];
+    config.proportion_right_turn_trucks = input_dict["proportion_right_turn_trucks"];
+    config.proportion_left_turn_trucks = input_dict["proportion_left_turn_trucks"];
+    config.counter_rng = input_dict["counter_rng"] != 0;
+    return config;
+}
+
+#endif
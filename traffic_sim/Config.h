@@ -0,0 +1,38 @@
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include <map>
+#include <string>
+
+// values read from the input file (see sample1); names match the keys
+struct SimulationConfig
+{
+    int maximum_simulated_time;
+    int number_of_sections_before_intersection;
+    int green_north_south;
+    int yellow_north_south;
+    int green_east_west;
+    int yellow_east_west;
+    double prob_new_vehicle_northbound;
+    double prob_new_vehicle_southbound;
+    double prob_new_vehicle_eastbound;
+    double prob_new_vehicle_westbound;
+    double proportion_of_cars;
+    double proportion_of_SUVs;
+    double proportion_right_turn_cars;
+    double proportion_left_turn_cars;
+    double proportion_right_turn_SUVs;
+    double proportion_left_turn_SUVs;
+    double proportion_right_turn_trucks;
+    double proportion_left_turn_trucks;
+    bool counter_rng; // 1 for the counter-based random numbers (CounterRng) instead of mt19937; --rng counter sets it
+};
+
+// read a file of "key: value" lines (any order, any whitespace, blank lines
+// ignored) into a dictionary; exits with a message if the file can't be opened
+std::map<std::string, double> readKeyValueFile(const std::string& fileName);
+
+// fill a SimulationConfig from the dictionary read out of an input file
+SimulationConfig makeConfig(std::map<std::string, double>& input_dict);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __COUNTER_RNG_CPP__
+#define __COUNTER_RNG_CPP__
+
+#include "CounterRng.h"
+
+using namespace::std;
+
+CounterRng::CounterRng(uint32_t seed, uint32_t stream)
+{
+    key[0] = seed;
+    key[1] = stream;
+}
+
+void CounterRng::fillUniforms(uint32_t first, uint32_t c1, int w, int count, double* out) const
+{
+    // the rounds of block(), run on LANES counters side by side (one array per word) so the
+    // compiler can keep them in vector registers
+    const int LANES = 8;
+    for (int base = 0; base < count; base += LANES)
+    {
+        uint32_t c[WORDS][LANES];
+        for (int i = 0; i < LANES; i++)
+        {
+            c[0][i] = first + base + i;
+            c[1][i] = c1;
+            c[2][i] = 0;
+            c[3][i] = 0;
+        }
+        uint32_t k0 = key[0];
+        uint32_t k1 = key[1];
+        for (int round = 0; round < 10; round++)
+        {
+            for (int i = 0; i < LANES; i++)
+            {
+                uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * c[0][i];
+                uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * c[2][i];
+                c[0][i] = static_cast<uint32_t>(product1 >> 32) ^ c[1][i] ^ k0;
+                c[1][i] = static_cast<uint32_t>(product1);
+                c[2][i] = static_cast<uint32_t>(product0 >> 32) ^ c[3][i] ^ k1;
+                c[3][i] = static_cast<uint32_t>(product0);
+            }
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        for (int i = 0; i < LANES && base + i < count; i++)
+            out[base + i] = toUniform(c[w][i]);
+    }
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef __COUNTER_RNG_H__
+#define __COUNTER_RNG_H__
+
+#include <cstdint>
+
+// Counter-based random numbers: Philox4x32-10 (Salmon, Moraes, Dror and
+// Shaw, "Parallel random numbers: as easy as 1, 2, 3", SC 2011). Instead
+// of a stream that has to be drawn from in order, every counter value is
+// hashed on its own into four 32-bit words under the key, so any draw can
+// be computed directly from where it is used. The intersections key it on
+// (seed, intersection) and count with (tick, direction), which makes each
+// approach's random numbers independent of the order anything else runs
+// in, or of whether idle ticks are skipped.
+class CounterRng
+{
+   private:
+      uint32_t key[2];
+
+      static inline uint32_t mulhilo(uint32_t a, uint32_t b, uint32_t& lo)
+      {
+         uint64_t product = static_cast<uint64_t>(a) * b;
+         lo = static_cast<uint32_t>(product);
+         return static_cast<uint32_t>(product >> 32);
+      }
+
+   public:
+      static const int WORDS = 4; // words per counter
+
+      CounterRng(uint32_t seed, uint32_t stream);
+
+      // the four words for counter (c0, c1, 0, 0)
+      inline void block(uint32_t c0, uint32_t c1, uint32_t out[WORDS]) const
+      {
+         uint32_t c[4] = {c0, c1, 0, 0};
+         uint32_t k0 = key[0];
+         uint32_t k1 = key[1];
+         for (int round = 0; round < 10; round++)
+         {
+            uint32_t lo0, lo1;
+            uint32_t hi0 = mulhilo(0xD2511F53u, c[0], lo0);
+            uint32_t hi1 = mulhilo(0xCD9E8D57u, c[2], lo1);
+            c[0] = hi1 ^ c[1] ^ k0;
+            c[1] = lo1;
+            c[2] = hi0 ^ c[3] ^ k1;
+            c[3] = lo0;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+         }
+         for (int w = 0; w < WORDS; w++)
+            out[w] = c[w];
+      }
+
+      // word w of counter (c0, c1) as a uniform double in [0, 1)
+      inline double uniform(uint32_t c0, uint32_t c1, int w) const
+      {
+         uint32_t out[WORDS];
+         block(c0, c1, out);
+         return toUniform(out[w]);
+      }
+
+      static inline double toUniform(uint32_t word) { return word * (1.0 / 4294967296.0); }
+
+      // word w of the counters (first + i, c1) for i from 0 to count - 1, as
+      // uniforms; the counters are independent, so the loop vectorizes
+      void fillUniforms(uint32_t first, uint32_t c1, int w, int count, double* out) const;
+};
+
+#endif
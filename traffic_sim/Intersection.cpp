@@ -0,0 +1,739 @@
+#ifndef __INTERSECTION_CPP__
+#define __INTERSECTION_CPP__
+
+#include <climits>
+#include <cmath>
+#include <sstream>
+#include "Checkpoint.h"
+#include "Intersection.h"
+
+using namespace::std;
+
+Intersection::Intersection(const SimulationConfig& config, const SignalTiming& timing, int index, int count, unsigned int seed)
+    : config(config), timing(timing), num_sec(config.number_of_sections_before_intersection),
+      lanes(4, Lane(config.number_of_sections_before_intersection)), vehicles(index, count), rand_double(0.0, 1.0),
+      counterRandom(config.counter_rng), counterRng(seed, index)
+{
+    rng.seed(seed); // call rand_double(rng) every time you want to get a new random
+
+    // set the initial light colors
+    northSouthLight = LightColor::red;
+    currentNS = 0;
+    eastWestLight = LightColor::green;
+    currentEW = timing.green_east_west + timing.yellow_east_west;
+    // no distinction for the vehicles between green and yellow
+    goEW = true; // EW light is initially green so goEW is initialized to true
+
+    arrivalProbability[static_cast<int>(Direction::north)] = config.prob_new_vehicle_northbound;
+    arrivalProbability[static_cast<int>(Direction::south)] = config.prob_new_vehicle_southbound;
+    arrivalProbability[static_cast<int>(Direction::east)] = config.prob_new_vehicle_eastbound;
+    arrivalProbability[static_cast<int>(Direction::west)] = config.prob_new_vehicle_westbound;
+
+    for (int d = 0; d < 4; d++)
+    {
+        genAmts[d] = 0;
+        generatesArrivals[d] = true;
+        lastAdmitted[d] = NO_VEHICLE;
+        feedsNeighbour[d] = false;
+        downstreamFull[d] = false;
+        exitCounts[d] = 0;
+        handoffCounts[d] = 0;
+        queueLengths[d] = 0;
+        nextArrival[d] = INT_MAX;
+        arrivalBlockStart[d] = INT_MIN; // nothing computed yet
+    }
+    scheduledArrivals = false;
+    completedVehicles = 0;
+    totalTravelTicks = 0;
+    totalDelayTicks = 0;
+}
+
+void Intersection::setGeneratesArrivals(Direction d, bool generates)
+{
+    generatesArrivals[static_cast<int>(d)] = generates;
+}
+
+void Intersection::setFeedsNeighbour(Direction d, bool feeds)
+{
+    feedsNeighbour[static_cast<int>(d)] = feeds;
+}
+
+void Intersection::save(CheckpointWriter& out) const
+{
+    out.put32(timing.green_north_south);
+    out.put32(timing.yellow_north_south);
+    out.put32(timing.green_east_west);
+    out.put32(timing.yellow_east_west);
+
+    for (const Lane& lane : lanes)
+        lane.save(out);
+    vehicles.save(out);
+
+    // the mt19937 state: the words the library writes it out as
+    stringstream rngState;
+    rngState << rng;
+    vector<uint32_t> words;
+    uint32_t word;
+    while (rngState >> word)
+        words.push_back(word);
+    out.putWords(words);
+
+    out.put32(currentNS);
+    out.put32(currentEW);
+    out.put8(goEW);
+    out.put8(static_cast<uint8_t>(northSouthLight));
+    out.put8(static_cast<uint8_t>(eastWestLight));
+    out.put8(scheduledArrivals);
+    for (int d = 0; d < 4; d++)
+    {
+        out.put32(genAmts[d]);
+        out.put32(nextArrival[d]);
+        out.put32(lastAdmitted[d]);
+        out.put32(exitCounts[d]);
+        out.put32(handoffCounts[d]);
+        out.put32(queueLengths[d]);
+        out.put8(downstreamFull[d]);
+        out.put32(entryQueues[d].size());
+        for (const HandoffSection& section : entryQueues[d])
+        {
+            out.putVarint(section.vehicleID);
+            out.put8(static_cast<uint8_t>(section.type));
+        }
+    }
+    out.put64(completedVehicles);
+    out.put64(totalTravelTicks);
+    out.put64(totalDelayTicks);
+    counters.save(out);
+    tripTimes.save(out);
+}
+
+void Intersection::restore(CheckpointReader& in)
+{
+    int greenNS = in.get32();
+    int yellowNS = in.get32();
+    int greenEW = in.get32();
+    int yellowEW = in.get32();
+    if (greenNS != timing.green_north_south || yellowNS != timing.yellow_north_south
+        || greenEW != timing.green_east_west || yellowEW != timing.yellow_east_west)
+        in.fail("written with different light timings");
+
+    for (Lane& lane : lanes)
+        lane.restore(in);
+    vehicles.restore(in);
+
+    stringstream rngState;
+    for (uint32_t word : in.getWords())
+        rngState << word << ' ';
+    rngState >> rng;
+    if (rngState.fail())
+        in.fail("bad random number state");
+
+    currentNS = in.get32();
+    currentEW = in.get32();
+    goEW = in.get8() != 0;
+    northSouthLight = static_cast<LightColor>(in.get8());
+    eastWestLight = static_cast<LightColor>(in.get8());
+    scheduledArrivals = in.get8() != 0;
+    for (int d = 0; d < 4; d++)
+    {
+        genAmts[d] = in.get32();
+        nextArrival[d] = in.get32();
+        lastAdmitted[d] = in.get32();
+        exitCounts[d] = in.get32();
+        handoffCounts[d] = in.get32();
+        queueLengths[d] = in.get32();
+        downstreamFull[d] = in.get8() != 0;
+        uint32_t queued = in.get32();
+        if (queued > ENTRY_QUEUE_CAPACITY)
+            in.fail("an entry queue longer than " + to_string(ENTRY_QUEUE_CAPACITY) + " sections");
+        entryQueues[d].resize(queued);
+        for (HandoffSection& section : entryQueues[d])
+        {
+            section.vehicleID = in.getVarint();
+            section.type = static_cast<VehicleType>(in.get8());
+        }
+        outboxes[d].clear();
+        arrivalBlockStart[d] = INT_MIN; // recomputed on the next draw
+    }
+    completedVehicles = in.get64();
+    totalTravelTicks = in.get64();
+    totalDelayTicks = in.get64();
+    counters.restore(in);
+    tripTimes.restore(in);
+}
+
+void Intersection::reseed(unsigned int seed, int index, int fromTick)
+{
+    rng.seed(seed);
+    counterRng = CounterRng(seed, index);
+    for (int d = 0; d < 4; d++)
+        arrivalBlockStart[d] = INT_MIN; // drawn from the old key
+    if (scheduledArrivals)
+        scheduleArrivals(fromTick);
+}
+
+void Intersection::resetStatistics()
+{
+    for (int d = 0; d < 4; d++)
+    {
+        exitCounts[d] = 0;
+        handoffCounts[d] = 0;
+    }
+    completedVehicles = 0;
+    totalTravelTicks = 0;
+    totalDelayTicks = 0;
+    counters = TrafficCounters();
+    tripTimes = TripTimes();
+}
+
+void Intersection::receive(Direction d, const vector<HandoffSection>& sections)
+{
+    deque<HandoffSection>& queue = entryQueues[static_cast<int>(d)];
+    queue.insert(queue.end(), sections.begin(), sections.end());
+}
+
+void Intersection::step(int tick)
+{
+    // whatever left the lanes last tick has been delivered by now
+    for (vector<HandoffSection>& outbox : outboxes)
+        outbox.clear();
+
+    // move the vehicles along the lanes with the kernels compiled for this geometry
+    withSectionCount(num_sec, [this, tick](auto sections) { moveLanes<decltype(sections)::value>(tick); });
+
+    updateLights();
+
+    // randomly generates which vehicles are to be created (if there is space for them, which is checked in loadVehicles)
+    array<VehicleType, 4> newVehicles = generate(tick);
+
+    // checks if there is space for a vehicle in that direction and if appropriate generates a vehicle with type and turn
+    // allows for continuous generation for the following parts of a vehicle
+    loadVehicles(newVehicles, lanes[static_cast<int>(Direction::north)], Direction::north, tick);
+    loadVehicles(newVehicles, lanes[static_cast<int>(Direction::south)], Direction::south, tick);
+    loadVehicles(newVehicles, lanes[static_cast<int>(Direction::east)], Direction::east, tick);
+    loadVehicles(newVehicles, lanes[static_cast<int>(Direction::west)], Direction::west, tick);
+
+    // the queues movePre found this tick
+    for (int d = 0; d < 4; d++)
+    {
+        counters.queueSectionTicks[d] += queueLengths[d];
+        if (queueLengths[d] > counters.maxQueue[d])
+            counters.maxQueue[d] = queueLengths[d];
+    }
+    counters.ticks++;
+}
+
+template <int SECTIONS>
+void Intersection::moveLanes(int tick)
+{
+    Lane& northbound = lanes[static_cast<int>(Direction::north)];
+    Lane& southbound = lanes[static_cast<int>(Direction::south)];
+    Lane& eastbound = lanes[static_cast<int>(Direction::east)];
+    Lane& westbound = lanes[static_cast<int>(Direction::west)];
+
+    // move passed vehicles, including those in the second phase of the intersection (past the point of no return)
+    movePassed<SECTIONS>(northbound, Direction::north, tick);
+    movePassed<SECTIONS>(southbound, Direction::south, tick);
+    movePassed<SECTIONS>(eastbound, Direction::east, tick);
+    movePassed<SECTIONS>(westbound, Direction::west, tick);
+
+    // move through intersection and turn if appropriate - only go if there's enough time to make it through
+    // pass all 4 lanes to method in order to handle left turns
+    if (goEW == true)
+    {
+        moveThrough<SECTIONS>(eastbound, southbound, northbound, westbound, currentEW);
+        moveThrough<SECTIONS>(westbound, northbound, southbound, eastbound, currentEW);
+    }
+    else
+    {
+        moveThrough<SECTIONS>(northbound, eastbound, westbound, southbound, currentNS);
+        moveThrough<SECTIONS>(southbound, westbound, eastbound, northbound, currentNS);
+    }
+
+    // move pre-intersection vehicles, noting the sections each lane had waiting at the stop line
+    queueLengths[static_cast<int>(Direction::north)] = movePre<SECTIONS>(northbound);
+    queueLengths[static_cast<int>(Direction::south)] = movePre<SECTIONS>(southbound);
+    queueLengths[static_cast<int>(Direction::east)] = movePre<SECTIONS>(eastbound);
+    queueLengths[static_cast<int>(Direction::west)] = movePre<SECTIONS>(westbound);
+}
+
+void Intersection::scheduleArrivals(int fromTick)
+{
+    scheduledArrivals = true;
+    for (int d = 0; d < 4; d++)
+        nextArrival[d] = generatesArrivals[d] ? drawNextArrival(d, fromTick) : INT_MAX;
+}
+
+bool Intersection::isIdle() const
+{
+    // every section on a lane (or still to be generated onto one) holds its vehicle's row
+    if (vehicles.getInUse() != 0)
+        return false;
+    for (int d = 0; d < 4; d++)
+        if (!entryQueues[d].empty())
+            return false;
+    return true;
+}
+
+int Intersection::getNextArrival() const
+{
+    int next = INT_MAX;
+    for (int d = 0; d < 4; d++)
+        next = min(next, nextArrival[d]);
+    return next;
+}
+
+void Intersection::skipIdleTicks(int ticks)
+{
+    // the lights repeat every full cycle (each phase lasts its green and yellow plus the tick it turns red on)
+    int cycle = timing.green_east_west + timing.yellow_east_west + timing.green_north_south + timing.yellow_north_south + 2;
+    for (int i = ticks % cycle; i > 0; i--)
+        updateLights();
+    // empty approaches add nothing to the queue totals
+    counters.ticks += ticks;
+}
+
+void Intersection::updateLights()
+{
+    // decrease currentEW or NS by 1 until it equals 0 and then change lights/direction of traffic flow
+    // change green to yellow during that process depending on length of yellow light
+    if (goEW == true) // EW is green or yellow
+    {
+        if (currentEW == 0) // lights are about to change
+        {
+            eastWestLight = LightColor::red;
+            goEW = 0; // time for north and south to move
+            northSouthLight = LightColor::green;
+            currentNS = timing.green_north_south + timing.yellow_north_south; // time left until NS is red
+        }
+        else if (currentEW == timing.yellow_east_west)
+        {
+            eastWestLight = LightColor::yellow;
+            currentEW--;
+        }
+        else
+            currentEW--;
+    }
+    else // NS is green or yellow
+    {
+        if (currentNS == 0) // lights are about to change
+        {
+            northSouthLight = LightColor::red;
+            eastWestLight = LightColor::green;
+            goEW = 1; // time for east and west to move
+            currentEW = timing.green_east_west + timing.yellow_east_west; // time left until EW is red
+        }
+        else if (currentNS == timing.yellow_north_south)
+        {
+            northSouthLight = LightColor::yellow;
+            currentNS--;
+        }
+        else
+            currentNS--;
+    }
+}
+
+array<VehicleType, 4> Intersection::generate(int tick)
+{
+    // one entry per Direction (north, south, east, west); approaches that don't generate arrivals, or where no
+    // vehicle should be generated this tick, get a 'none' vehicle type (added to the enum class) to keep the ordering
+    array<VehicleType, 4> generatedVehicles;
+    for (int d = 0; d < 4; d++)
+    {
+        if (!generatesArrivals[d])
+            generatedVehicles[d] = VehicleType::none;
+        else if (!scheduledArrivals)
+            generatedVehicles[d] = generateType(d, tick);
+        else if (tick == nextArrival[d])
+        {
+            generatedVehicles[d] = drawType(d, tick);
+            nextArrival[d] = drawNextArrival(d, tick + 1);
+        }
+        else
+            generatedVehicles[d] = VehicleType::none;
+    }
+    return generatedVehicles;
+}
+
+VehicleType Intersection::generateType(int dirInt, int tick)
+{
+    // checks if a vehicle should be generated
+    double arrivalRand = counterRandom ? arrivalUniform(dirInt, tick) : rand_double(rng);
+    if(arrivalRand < arrivalProbability[dirInt])
+        return drawType(dirInt, tick);
+    return VehicleType::none;
+}
+
+VehicleType Intersection::drawType(int dirInt, int tick)
+{
+    double typeRand = drawUniform(dirInt, tick, 1); // generates a new random number to be used for vehicle type calculations
+    if (typeRand < config.proportion_of_cars) // checks if a car should be created
+        return VehicleType::car;
+    else if (typeRand < config.proportion_of_SUVs + config.proportion_of_cars) // checks if a suv should be created
+        return VehicleType::suv;
+    else // if not car or suv, create a truck
+        return VehicleType::truck;
+}
+
+double Intersection::drawUniform(int dirInt, int tick, int word)
+{
+    if (counterRandom)
+        return counterRng.uniform(tick, dirInt, word);
+    return rand_double(rng);
+}
+
+double Intersection::arrivalUniform(int dirInt, int tick)
+{
+    int& start = arrivalBlockStart[dirInt];
+    if (tick < start || tick >= start + ARRIVAL_BLOCK)
+    {
+        start = tick;
+        counterRng.fillUniforms(tick, dirInt, 0, ARRIVAL_BLOCK, arrivalUniforms[dirInt]);
+    }
+    return arrivalUniforms[dirInt][tick - start];
+}
+
+int Intersection::drawNextArrival(int dirInt, int fromTick)
+{
+    if (!counterRandom)
+        return fromTick + arrivalGap(arrivalProbability[dirInt]);
+
+    // the counter-based draws are fixed for every tick, so find the first one that is an arrival: the same
+    // arrivals as drawing tick by tick
+    for (int tick = fromTick; tick < config.maximum_simulated_time; tick++)
+        if (arrivalUniform(dirInt, tick) < arrivalProbability[dirInt])
+            return tick;
+    return INT_MAX / 2;
+}
+
+int Intersection::arrivalGap(double probability)
+{
+    // ticks without an arrival before the next one, when each tick has an arrival with the given probability:
+    // geometric, drawn by inverting its distribution function
+    if (probability >= 1)
+        return 0;
+    if (probability <= 0)
+        return INT_MAX / 2; // never (and still safe to add a tick number to)
+    double gap = floor(log1p(-rand_double(rng)) / log1p(-probability));
+    return gap < INT_MAX / 2 ? static_cast<int>(gap) : INT_MAX / 2;
+}
+
+Turn Intersection::drawTurn(VehicleType type, int dirInt, int tick)
+{
+    double rightProportion = config.proportion_right_turn_cars;
+    double leftProportion = config.proportion_left_turn_cars;
+    if (type == VehicleType::suv)
+    {
+        rightProportion = config.proportion_right_turn_SUVs;
+        leftProportion = config.proportion_left_turn_SUVs;
+    }
+    else if (type == VehicleType::truck)
+    {
+        rightProportion = config.proportion_right_turn_trucks;
+        leftProportion = config.proportion_left_turn_trucks;
+    }
+
+    double turnRand = drawUniform(dirInt, tick, 2);  // generates a random number to determine if vehicle will turn
+    if (turnRand < rightProportion)
+        return Turn::right;
+    else if (turnRand < rightProportion + leftProportion)
+        return Turn::left;
+    return Turn::straight;
+}
+
+void Intersection::loadVehicles(const array<VehicleType, 4>& newVehicles, Lane &v, Direction d, int tick)
+{
+    int dirInt = static_cast<underlying_type<Direction>::type>(d); // index of this direction in newVehicles and genAmts
+    int typeInt = static_cast<int>(newVehicles[dirInt]);          // and of the generated vehicle's type in the counters
+
+    if(v[0] == NO_VEHICLE)
+    {
+        if(genAmts[dirInt] != 0)
+        {
+            v[0] = v[1]; // the rest of the vehicle placed at v[0] last tick (and since moved to v[1]) follows it in
+            genAmts[dirInt]--;
+            if(newVehicles[dirInt] != VehicleType::none) // a vehicle generated now has nowhere to go
+                counters.blockedArrivals[dirInt][typeInt]++;
+        }
+        else if(!generatesArrivals[dirInt])
+            admitVehicle(v, d, tick);
+        // create new vehicle of specified type and a turn drawn for it, and set genAmts to
+        // how many sections are left in the generated car (1), suv (2) or truck (3)
+        // the last two arguments of acquire are the number of sections it occupies and its entry tick
+        else if(newVehicles[dirInt] == VehicleType::car)
+        {
+            v[0] = vehicles.acquire(VehicleType::car, d, drawTurn(VehicleType::car, dirInt, tick), 2, tick);
+            genAmts[dirInt] = 1;
+            counters.arrivals[dirInt][typeInt]++;
+        }
+        else if(newVehicles[dirInt] == VehicleType::suv)
+        {
+            v[0] = vehicles.acquire(VehicleType::suv, d, drawTurn(VehicleType::suv, dirInt, tick), 3, tick);
+            genAmts[dirInt] = 2;
+            counters.arrivals[dirInt][typeInt]++;
+        }
+        else if(newVehicles[dirInt] == VehicleType::truck)
+        {
+            v[0] = vehicles.acquire(VehicleType::truck, d, drawTurn(VehicleType::truck, dirInt, tick), 4, tick);
+            genAmts[dirInt] = 3;
+            counters.arrivals[dirInt][typeInt]++;
+        }
+    }
+    else if(newVehicles[dirInt] != VehicleType::none) // the start of the lane is taken
+        counters.blockedArrivals[dirInt][typeInt]++;
+
+}
+
+void Intersection::admitVehicle(Lane &v, Direction d, int tick)
+{
+    // take the next section handed off by the upstream intersection, if any
+    int dirInt = static_cast<int>(d);
+    deque<HandoffSection>& queue = entryQueues[dirInt];
+    if (queue.empty())
+        return;
+    HandoffSection section = queue.front();
+    queue.pop_front();
+
+    // a section following the one admitted before it belongs to the same vehicle (its row is still in use);
+    // otherwise this is the front of a new vehicle, which decides its turn here
+    VehicleIndex previous = lastAdmitted[dirInt];
+    if (previous != NO_VEHICLE && vehicles.getSectionsLeft(previous) > 0 && vehicles.getVehicleID(previous) == section.vehicleID)
+    {
+        vehicles.addSection(previous);
+        v[0] = previous;
+        return;
+    }
+
+    int sections = section.type == VehicleType::car ? 2 : (section.type == VehicleType::suv ? 3 : 4);
+    v[0] = vehicles.admit(section.vehicleID, section.type, d, drawTurn(section.type, dirInt, tick), sections, tick);
+    lastAdmitted[dirInt] = v[0];
+    counters.arrivals[dirInt][static_cast<int>(section.type)]++;
+}
+
+template <int SECTIONS>
+void Intersection::movePassed(LaneView<SECTIONS> v, Direction d, int tick)
+{
+    const int num_sec = v.sectionsBefore();
+    int dirInt = static_cast<int>(d);
+
+    // the section at the end waits while the next intersection's entry queue is full; the rest close up behind it
+    if (feedsNeighbour[dirInt] && downstreamFull[dirInt] && v[num_sec * 2 + 1] != NO_VEHICLE)
+    {
+        v.holdOutbound();
+        return;
+    }
+
+    // move each vehicle past the point of no return one section forward (a single step of the lane's circular buffer)
+    VehicleIndex leaving = v.advanceOutbound();
+    if (leaving == NO_VEHICLE)
+        return;
+
+    // the section at the end either leaves the network or moves on to the next intersection
+    if (feedsNeighbour[dirInt])
+        outboxes[dirInt].push_back({vehicles.getVehicleID(leaving), vehicles.getType(leaving)});
+
+    // record the vehicle's trip through the lane and free its row once its last section is gone
+    int travelTicks = tick - vehicles.getEntryTick(leaving);
+    // unimpeded, the front section takes (num_sec * 2) + 2 ticks to cross the lane and each further section
+    // one tick more; a right turn skips a section
+    int freeFlowTicks = num_sec * 2 + 1 + vehicles.getLength(leaving) - (vehicles.getTurn(leaving) == Turn::right ? 1 : 0);
+    int typeInt = static_cast<int>(vehicles.getType(leaving));
+    Turn turn = vehicles.getTurn(leaving);
+    if (vehicles.releaseSection(leaving))
+    {
+        int delayTicks = travelTicks > freeFlowTicks ? travelTicks - freeFlowTicks : 0;
+        counters.departures[dirInt][typeInt]++;
+        tripTimes.record(d, turn, travelTicks, delayTicks);
+        completedVehicles++;
+        totalTravelTicks += travelTicks;
+        totalDelayTicks += delayTicks;
+        if (feedsNeighbour[dirInt])
+            handoffCounts[dirInt]++;
+        else
+            exitCounts[dirInt]++;
+    }
+}
+
+template <int SECTIONS>
+int Intersection::movePre(LaneView<SECTIONS> v)
+{
+    // move vehicle sections forward if there's no vehicle in front of it (or the one in front moves too);
+    // the lane does it in time proportional to the queue at the intersection, not to the number of sections
+    return v.advanceApproach();
+}
+
+template <int SECTIONS>
+void Intersection::placeSection(LaneView<SECTIONS> v, int index, VehicleIndex vehicle)
+{
+    // a crossing vehicle can land on a section that is already occupied (e.g. a right turn onto a lane whose
+    // straight-through vehicle just cleared the intersection); the overwritten section is gone from the road,
+    // so count it as released or its vehicle's row would never be freed
+    if (v[index] != NO_VEHICLE)
+        vehicles.releaseSection(v[index]);
+    v[index] = vehicle;
+}
+
+// a crossing vehicle can't land on lane[index]: it's taken by a section the lane is holding back for the next intersection
+template <int SECTIONS>
+static inline bool landingHeld(LaneView<SECTIONS> lane, int index)
+{
+    return lane.isOutboundHeld() && lane[index] != NO_VEHICLE;
+}
+
+template <int SECTIONS>
+void Intersection::moveThrough(LaneView<SECTIONS> v, LaneView<SECTIONS> r, LaneView<SECTIONS> l, LaneView<SECTIONS> o,
+                               int currentTimeLeft)
+{
+    const int num_sec = v.sectionsBefore();
+
+    // handle vehicles in 1st section of intersection (where they will either turn straight, right, or left);
+    // one whose way out is taken by a section held back for the next intersection waits where it is
+    if(v[num_sec] != NO_VEHICLE)
+    {
+        // send vehicle forward if it's going straight
+        if(vehicles.getTurn(v[num_sec]) == Turn::straight)
+        {
+            if(!landingHeld(v, num_sec+1))
+            {
+                placeSection(v, num_sec+1, v[num_sec]);
+                v[num_sec] = NO_VEHICLE;
+            }
+        }
+        // send vehicle to the right if it's going right
+        else if (vehicles.getTurn(v[num_sec]) == Turn::right)
+        {
+            if(!landingHeld(r, num_sec+2))
+            {
+                placeSection(r, num_sec+2, v[num_sec]);
+                v[num_sec] = NO_VEHICLE;
+            }
+        } 
+        // send vehicle to the left if it's going left
+        else
+        {
+            if(!landingHeld(l, num_sec+1))
+            {
+                placeSection(l, num_sec+1, v[num_sec]);
+                v[num_sec] = NO_VEHICLE;
+            }
+        }       
+    }
+    
+    // handle vehicles in section right before intersection (unless the one in the intersection is still waiting)
+    // determine if they can go based on how much time is left before their light turns red
+    // for left turns, also consider what happens when both directions want to turn left
+    if(v[num_sec-1] != NO_VEHICLE && v[num_sec] == NO_VEHICLE)
+    {
+        // lane and type of the vehicle at the stop line, for the counters
+        int dirInt = static_cast<int>(vehicles.getDirection(v[num_sec-1]));
+        int typeInt = static_cast<int>(vehicles.getType(v[num_sec-1]));
+        int lengthLeft = 0; // number of sections until vehicle is fully into the intersection
+        int i = num_sec-2;
+        while(i >= 0 && v[i]==v[num_sec-1]) // determine how much of the vehicle is left before the intersection
+        {
+            lengthLeft++;
+            i--;
+        }
+        // determine if vehicle can make it through before light turns red and move accordingly
+        // takes one less tick to get through right turn so right turn uses counter + 1 instead of + 2
+        if(vehicles.getTurn(v[num_sec-1]) == Turn::straight && lengthLeft + 2 <= currentTimeLeft)
+        {
+            v[num_sec]=v[num_sec-1];
+            v[num_sec-1] = NO_VEHICLE;
+        }
+        else if(vehicles.getTurn(v[num_sec-1]) == Turn::right && lengthLeft + 1 <= currentTimeLeft)
+        {
+            v[num_sec]=v[num_sec-1];
+            v[num_sec-1] = NO_VEHICLE;
+        }
+        else if(vehicles.getTurn(v[num_sec-1]) == Turn::left && lengthLeft + 2 <= currentTimeLeft)
+        {
+            // find closest oncoming vehicle and determine if a collision will happen
+            bool collision = false;
+            for(int j = num_sec + 1; j > num_sec - lengthLeft - 3; j--)
+            {
+                if(j >= 0)
+                {
+                    // sections held back for the next intersection aren't coming through: skip those past the
+                    // intersection, and stop at one waiting in it, since nothing behind it can move either
+                    // (the oncoming lane's right is this lane's left, and its left this lane's right)
+                    if(o[j] != NO_VEHICLE && j > num_sec && o.isOutboundHeld())
+                        continue;
+                    if(j == num_sec && o[j] != NO_VEHICLE
+                       && ((vehicles.getTurn(o[j]) == Turn::straight && landingHeld(o, num_sec+1))
+                           || (vehicles.getTurn(o[j]) == Turn::right && landingHeld(l, num_sec+2))
+                           || (vehicles.getTurn(o[j]) == Turn::left && landingHeld(r, num_sec+1))))
+                        j = -1;
+                    else if(o[j] != NO_VEHICLE)
+                    {
+                        int oppLengthLeft = 0;
+                        int k = j-1;
+                        while(k >= 0 && v[k]==v[j]) // determine how much of the oncoming vehicle is left before the intersection
+                        {
+                            oppLengthLeft++;
+                            k--;
+                        }
+
+                        // determine how much time the oncoming vehicle will take to go through the intersection
+                        int oppTimeUntilThrough;
+                        if(vehicles.getTurn(o[j]) == Turn::right)
+                            oppTimeUntilThrough = oppLengthLeft + 1 + (num_sec - j - 1);
+                        else
+                            oppTimeUntilThrough = oppLengthLeft + 2 + (num_sec - j - 1);
+
+                        // if oncoming vehicle turning left, give northbound and eastbound vehicles priority
+                        // if oncoming vehicle is also turning left and my vehicle is north or east, ignore it and go
+                        if(vehicles.getTurn(o[j]) == Turn::left &&
+                        (vehicles.getDirection(v[num_sec-1]) == Direction::north ||
+                        vehicles.getDirection(v[num_sec-1]) == Direction::east))    
+                        {
+                            j = -1;
+                        }
+                        // if oncoming vehicle does not have enough time to get through light, ignore it and go
+                        else if(oppTimeUntilThrough > currentTimeLeft)           
+                        { 
+                            j = -1;
+                        }
+                        // oncoming vehicle will be going through the intersection, so stop
+                        else
+                        {
+                            collision = true;
+                            j = -1;
+                        }    
+                    }
+                } 
+            }
+            // if there won't be a collision, move forward into intersection (actual left turn handled on next tick)
+            if(!collision)
+            {
+                // check to make sure next space is not already occupied before moving (a section held there for the
+                // next intersection doesn't count: it isn't going anywhere)
+                if(r[num_sec+1] == NO_VEHICLE || r.isOutboundHeld())
+                {
+                    v[num_sec]=v[num_sec-1]; 
+                    v[num_sec-1] = NO_VEHICLE;
+                }
+            }
+            else
+                counters.leftTurnsHeld[dirInt][typeInt]++;
+
+        }
+        
+    }
+}
+
+// Bench.cpp calls the kernels one phase at a time, so compile them here for every case of withSectionCount
+template void Intersection::movePassed<0>(LaneView<0>, Direction, int);
+template int Intersection::movePre<0>(LaneView<0>);
+template void Intersection::moveThrough<0>(LaneView<0>, LaneView<0>, LaneView<0>, LaneView<0>, int);
+template void Intersection::movePassed<9>(LaneView<9>, Direction, int);
+template int Intersection::movePre<9>(LaneView<9>);
+template void Intersection::moveThrough<9>(LaneView<9>, LaneView<9>, LaneView<9>, LaneView<9>, int);
+template void Intersection::movePassed<10>(LaneView<10>, Direction, int);
+template int Intersection::movePre<10>(LaneView<10>);
+template void Intersection::moveThrough<10>(LaneView<10>, LaneView<10>, LaneView<10>, LaneView<10>, int);
+template void Intersection::movePassed<20>(LaneView<20>, Direction, int);
+template int Intersection::movePre<20>(LaneView<20>);
+template void Intersection::moveThrough<20>(LaneView<20>, LaneView<20>, LaneView<20>, LaneView<20>, int);
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef __INTERSECTION_H__
+#define __INTERSECTION_H__
+
+#include <array>
+#include <deque>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "Config.h"
+#include "CounterRng.h"
+#include "Lane.h"
+#include "Metrics.h"
+#include "VehicleBase.h"
+#include "VehicleTable.h"
+
+// green and yellow lengths for one intersection's lights
+struct SignalTiming
+{
+    int green_north_south;
+    int yellow_north_south;
+    int green_east_west;
+    int yellow_east_west;
+};
+
+// one section of a vehicle leaving an intersection toward the next one in
+// the network; sections of the same vehicle are sent one per tick, in order
+struct HandoffSection
+{
+    VehicleID   vehicleID;
+    VehicleType type;
+};
+
+// One signalled intersection: the four lanes through it, the vehicles on
+// them, its lights, and its own random number stream.
+//
+// Each approach either generates its own arrivals (edge of the network) or
+// is fed sections handed off by the upstream intersection through its
+// entry queue. Likewise each lane either ends at the edge of the network,
+// where vehicles leave the simulation, or feeds the next intersection, in
+// which case sections leaving it are collected in its outbox for the
+// Network to deliver. An entry queue only holds ENTRY_QUEUE_CAPACITY
+// sections: while the one a lane feeds is full, the section at the end of
+// the lane waits there (Lane::holdOutbound), so a jam downstream backs up
+// onto the lanes before it instead of piling up out of sight.
+class Intersection
+{
+   private:
+      friend class IntersectionBench; // Bench.cpp times the per-tick kernels below one at a time
+
+      const SimulationConfig& config;
+      SignalTiming timing;
+      int num_sec; // number_of_sections_before_intersection
+
+      std::vector<Lane> lanes; // indexed by Direction
+      VehicleTable vehicles;
+
+      std::mt19937 rng; // this intersection's random number stream
+      std::uniform_real_distribution<double> rand_double;
+
+      // with config.counter_rng, every draw comes from counterRng instead,
+      // at counter (tick, direction): word 0 decides the arrival, 1 its
+      // type and 2 its turn
+      bool counterRandom;
+      CounterRng counterRng; // keyed on (seed, intersection index)
+      static const int ARRIVAL_BLOCK = 64;
+      double arrivalUniforms[4][ARRIVAL_BLOCK]; // each approach's arrival draws for the ticks from...
+      int arrivalBlockStart[4];                 // ...here on, computed a block at a time
+
+      int currentNS; // time left until NS is red
+      int currentEW; // time left until EW is red
+      bool goEW;     // true while EW is green or yellow
+      LightColor northSouthLight;
+      LightColor eastWestLight;
+
+      // genAmts[d] is how many more sections of the vehicle that was just
+      // generated in direction d still have to be placed at the start of that
+      // lane (one per tick, as the lane frees up); no new vehicle is generated
+      // in that direction until it reaches 0
+      int genAmts[4];
+      double arrivalProbability[4];
+      bool scheduledArrivals; // draw the gap to each approach's next arrival instead of one draw per tick
+      int nextArrival[4];     // with scheduledArrivals: tick of the next arrival at each approach
+
+      bool generatesArrivals[4];  // edge approaches generate their own vehicles...
+      std::deque<HandoffSection> entryQueues[4]; // ...the rest take them from here
+      VehicleIndex lastAdmitted[4]; // row of the vehicle most recently taken from each entry queue
+
+      bool feedsNeighbour[4];     // lanes that continue into another intersection
+      std::vector<HandoffSection> outboxes[4]; // sections that left those lanes this tick
+      bool downstreamFull[4];     // the entry queue each of them feeds was full after the last delivery
+
+      int exitCounts[4];    // vehicles that left the network at the end of each lane
+      int handoffCounts[4]; // vehicles passed on to the next intersection from each lane
+      long long completedVehicles; // vehicles whose last section has left one of the lanes
+      long long totalTravelTicks;  // summed over them: ticks from entering the lane to leaving it
+      long long totalDelayTicks;   // summed over them: ticks beyond an unimpeded trip through the lane
+
+      TrafficCounters counters;
+      TripTimes tripTimes; // per-vehicle travel time and delay, recorded as the last section leaves
+      int queueLengths[4]; // sections that waited at the stop line (packed back from it) in each lane last tick
+
+      std::array<VehicleType, 4> generate(int tick);
+      VehicleType generateType(int dirInt, int tick);
+      VehicleType drawType(int dirInt, int tick);
+      Turn drawTurn(VehicleType type, int dirInt, int tick);
+      double drawUniform(int dirInt, int tick, int word);
+      double arrivalUniform(int dirInt, int tick);
+      int drawNextArrival(int dirInt, int fromTick);
+      int arrivalGap(double probability);
+      void loadVehicles(const std::array<VehicleType, 4>& newVehicles, Lane& v, Direction d, int tick);
+      void admitVehicle(Lane& v, Direction d, int tick);
+      // the lane kernels, compiled once per section count step() has a
+      // specialization for and once (SECTIONS == 0) for any other
+      template <int SECTIONS> void moveLanes(int tick);
+      template <int SECTIONS> void movePassed(LaneView<SECTIONS> v, Direction d, int tick);
+      template <int SECTIONS> int movePre(LaneView<SECTIONS> v);
+      template <int SECTIONS> void moveThrough(LaneView<SECTIONS> v, LaneView<SECTIONS> r, LaneView<SECTIONS> l,
+                                               LaneView<SECTIONS> o, int currentTimeLeft);
+      template <int SECTIONS> void placeSection(LaneView<SECTIONS> v, int index, VehicleIndex vehicle);
+      void updateLights();
+
+   public:
+      // index and count are this intersection's position among count
+      // intersections (used to keep vehicle IDs unique across the network)
+      Intersection(const SimulationConfig& config, const SignalTiming& timing, int index, int count, unsigned int seed);
+      Intersection(const Intersection& other) = delete;
+      Intersection& operator=(const Intersection& other) = delete;
+
+      // set which approaches generate arrivals and which lanes feed a
+      // neighbour; by default the intersection stands alone (all four of each)
+      void setGeneratesArrivals(Direction d, bool generates);
+      void setFeedsNeighbour(Direction d, bool feeds);
+
+      // advance everything at this intersection by one tick
+      void step(int tick);
+
+      // Call kernel with std::integral_constant<int, SECTIONS>: SECTIONS is
+      // sections when the lane kernels have been compiled for that many
+      // sections before the intersection (the geometries we run most, like
+      // sample1's 9), otherwise 0 for the kernels that read it at run time.
+      // Adding a case here is all it takes to specialize another geometry.
+      template <class Kernel>
+      static auto withSectionCount(int sections, Kernel kernel)
+      {
+         switch (sections)
+         {
+            case 9:  return kernel(std::integral_constant<int, 9>());
+            case 10: return kernel(std::integral_constant<int, 10>());
+            case 20: return kernel(std::integral_constant<int, 20>());
+            default: return kernel(std::integral_constant<int, 0>());
+         }
+      }
+
+      // Next-event mode: from fromTick on, sample each approach's next
+      // arrival from the geometric distribution of the per-tick arrival
+      // probability instead of drawing every tick, so the ticks in between
+      // can be skipped when nothing is on the road. The arrivals have the
+      // same distribution, but the random numbers are used differently, so a
+      // run no longer matches the tick-by-tick one for the same seed.
+      void scheduleArrivals(int fromTick);
+      // no vehicle on or waiting to enter any lane
+      bool isIdle() const;
+      // with scheduled arrivals: the earliest tick anything arrives
+      int getNextArrival() const;
+      // advance the clock by ticks on which, being idle, only the lights change
+      void skipIdleTicks(int ticks);
+
+      // everything that changes as the intersection runs, for checkpoints;
+      // restore() expects an intersection built from the same config,
+      // timing and position, and exits if the checkpoint doesn't match
+      void save(CheckpointWriter& out) const;
+      void restore(CheckpointReader& in);
+
+      // Switch to the random number streams of another seed from here on
+      // (index is the intersection's position, as in the constructor); with
+      // scheduled arrivals, the next arrival at each approach is redrawn
+      // from fromTick on so it comes from the new stream too.
+      void reseed(unsigned int seed, int index, int fromTick);
+      // zero the exit counts, travel totals, counters and trip times, so
+      // they only cover the ticks from here on (vehicles on the road stay)
+      void resetStatistics();
+
+      // hand-off between neighbours
+      inline std::vector<HandoffSection>& getOutbox(Direction d) { return outboxes[static_cast<int>(d)]; }
+      void receive(Direction d, const std::vector<HandoffSection>& sections);
+
+      // Back-pressure: a lane hands on at most a section a tick and an
+      // approach takes in at most one, but a lane only learns whether the
+      // queue it feeds has room from the delivery before, so the queue holds
+      // the section delivered last tick plus one more. After each delivery
+      // the Network tells the upstream intersection whether the queue is full
+      // (length >= ENTRY_QUEUE_CAPACITY), and the lane holds its last section
+      // on the next tick if so.
+      static const int ENTRY_QUEUE_CAPACITY = 2;
+      inline int  getEntryQueueLength(Direction d) const { return entryQueues[static_cast<int>(d)].size(); }
+      inline void setDownstreamFull(Direction d, bool full) { downstreamFull[static_cast<int>(d)] = full; }
+
+      inline Lane&         getLane(Direction d) { return lanes[static_cast<int>(d)]; }
+      inline VehicleTable& getVehicles() { return vehicles; }
+      inline LightColor    getLightNorthSouth() const { return northSouthLight; }
+      inline LightColor    getLightEastWest() const { return eastWestLight; }
+      inline int           getExitCount(Direction d) const { return exitCounts[static_cast<int>(d)]; }
+      inline int           getHandoffCount(Direction d) const { return handoffCounts[static_cast<int>(d)]; }
+      inline long long     getCompletedVehicles() const { return completedVehicles; }
+      inline long long     getTotalTravelTicks() const { return totalTravelTicks; }
+      inline long long     getTotalDelayTicks() const { return totalDelayTicks; }
+      inline const TrafficCounters& getCounters() const { return counters; }
+      inline const TripTimes& getTripTimes() const { return tripTimes; }
+      inline int           getQueueLength(Direction d) const { return queueLengths[static_cast<int>(d)]; }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef __LANE_CPP__
+#define __LANE_CPP__
+
+#include <algorithm>
+#include "Checkpoint.h"
+#include "Lane.h"
+
+using namespace::std;
+
+Lane::Lane(int numSectionsBeforeIntersection) : numSectionsBefore(numSectionsBeforeIntersection),
+    approachHead(0), head(0), outboundHeld(false), cells(numSectionsBeforeIntersection * 2 + 2, NO_VEHICLE)
+{
+
+}
+
+static VehicleBase* laneSection(const void* lane, void* table, int section)
+{
+    return static_cast<VehicleTable*>(table)->view((*static_cast<const Lane*>(lane))[section]);
+}
+
+LaneVehicles Lane::animatorView(VehicleTable& table) const
+{
+    return LaneVehicles(this, &table, &laneSection);
+}
+
+void Lane::save(CheckpointWriter& out) const
+{
+    out.put32(approachHead);
+    out.put32(head);
+    out.putWords(cells);
+}
+
+void Lane::restore(CheckpointReader& in)
+{
+    approachHead = in.get32();
+    head = in.get32();
+    vector<VehicleIndex> saved = in.getWords();
+    if (saved.size() != cells.size() || approachHead < 0 || approachHead >= max(numSectionsBefore, 1)
+        || head < 0 || head > numSectionsBefore)
+        in.fail("lanes of a different length");
+    cells = saved;
+    outboundHeld = false; // set afresh by the next tick's advanceOutbound or holdOutbound
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef __LANE_H__
+#define __LANE_H__
+
+#include <vector>
+#include "LaneVehicles.h"
+#include "VehicleBase.h"
+#include "VehicleTable.h"
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// One direction of travel through the intersection: numSectionsBefore
+// sections approaching it, the two intersection sections, then
+// numSectionsBefore sections leaving it, for (numSectionsBefore * 2) + 2
+// sections indexed from 0 exactly like the vector<VehicleBase*> the
+// Animator draws. Each section holds the VehicleTable row of the vehicle
+// occupying it, or NO_VEHICLE.
+//
+// Everything from the second intersection section (index
+// numSectionsBefore + 1) to the end of the lane moves forward together
+// every tick, so that outbound part is kept in a circular buffer and
+// advancing it just moves the head offset instead of shifting every
+// section.
+//
+// The approach (indices 0 to numSectionsBefore - 1) is a circular buffer
+// too: each tick every section on it moves forward one except the queue
+// packed up against the intersection, so advancing it moves the head
+// offset and then shifts only that queue back into place.
+//
+// When the next intersection has no room for the section at the end of
+// the lane, the outbound part is held instead: the section stays at the
+// end and the ones behind it close up against it the same way.
+class Lane
+{
+   private:
+      int numSectionsBefore;
+      int approachHead;   // buffer position of the section at index 0
+      int head;           // buffer position of the section at index numSectionsBefore + 1
+      bool outboundHeld;  // the outbound part was held rather than advanced this tick
+      std::vector<VehicleIndex> cells; // approach buffer, first intersection section, then the outbound buffer
+
+   public:
+      Lane(int numSectionsBeforeIntersection);
+
+      inline int size() const { return numSectionsBefore * 2 + 2; }
+
+      // numSectionsBefore, or SECTIONS when the caller was compiled for
+      // that geometry (see LaneView); SECTIONS == 0 means any geometry
+      template <int SECTIONS>
+      inline int sectionsBefore() const { return SECTIONS > 0 ? SECTIONS : numSectionsBefore; }
+
+      template <int SECTIONS>
+      inline VehicleIndex& at(int i)
+      {
+         const int n = sectionsBefore<SECTIONS>();
+         if (i < n)
+         {
+            int a = approachHead + i;
+            if (a >= n)
+               a -= n;
+            return cells[a];
+         }
+         if (i == n)
+            return cells[i];
+         int k = head + i - n - 1;
+         if (k >= n + 1)
+            k -= n + 1;
+         return cells[n + 1 + k];
+      }
+      inline VehicleIndex& operator[](int i) { return at<0>(i); }
+      inline VehicleIndex operator[](int i) const
+            { return const_cast<Lane&>(*this)[i]; }
+
+      // move every section from index numSectionsBefore + 1 onward one
+      // section forward, leaving that index empty; returns the section that
+      // was at the end of the lane (NO_VEHICLE if none), which leaves the lane
+      template <int SECTIONS = 0>
+      VehicleIndex advanceOutbound();
+
+      // instead of advanceOutbound, while the section at the end of the
+      // lane can't leave: move every section from index numSectionsBefore +
+      // 1 onward forward one if the section in front of it is empty or moves
+      // too, so they close up behind the one at the end
+      template <int SECTIONS = 0>
+      void holdOutbound();
+      inline bool isOutboundHeld() const { return outboundHeld; }
+
+      // move every section of the approach into the section in front of
+      // it, if that section is empty or its occupant moves too (the order
+      // Intersection::movePre used to do it in, front to back); the section
+      // at index numSectionsBefore - 1 only moves into the intersection in
+      // Intersection::moveThrough; returns the length of the queue, the
+      // sections packed back from the stop line (index numSectionsBefore - 1)
+      // that had to stay where they were
+      template <int SECTIONS = 0>
+      int advanceApproach();
+
+      // the lane as the Animator reads it: section i is table.view((*this)[i]);
+      // nothing is copied, so it sees the lane as it is when drawn
+      LaneVehicles animatorView(VehicleTable& table) const;
+
+      // sections and buffer positions, for checkpoints
+      void save(CheckpointWriter& out) const;
+      void restore(CheckpointReader& in);
+};
+
+// A Lane seen through a section count fixed at compile time (SECTIONS >
+// 0, which must match the lane), so the kernels templated on it index it
+// with constant bounds and wrap-arounds the compiler can fold and unroll;
+// LaneView<0> reads the count from the lane and works for any geometry.
+template <int SECTIONS>
+class LaneView
+{
+   private:
+      Lane* lane;
+
+   public:
+      inline LaneView(Lane& lane) : lane(&lane) { }
+
+      inline VehicleIndex& operator[](int i) const { return lane->at<SECTIONS>(i); }
+      inline int sectionsBefore() const { return lane->sectionsBefore<SECTIONS>(); }
+      inline VehicleIndex advanceOutbound() const { return lane->advanceOutbound<SECTIONS>(); }
+      inline void holdOutbound() const { lane->holdOutbound<SECTIONS>(); }
+      inline bool isOutboundHeld() const { return lane->isOutboundHeld(); }
+      inline int advanceApproach() const { return lane->advanceApproach<SECTIONS>(); }
+};
+
+template <int SECTIONS>
+VehicleIndex Lane::advanceOutbound()
+{
+    // stepping the head back one slot turns the last section into the first;
+    // take what was there (it has left the lane) and clear it
+    const int n = sectionsBefore<SECTIONS>();
+    head = (head == 0 ? n : head - 1);
+    VehicleIndex& slot = cells[n + 1 + head];
+    VehicleIndex leaving = slot;
+    slot = NO_VEHICLE;
+    outboundHeld = false;
+    return leaving;
+}
+
+template <int SECTIONS>
+void Lane::holdOutbound()
+{
+    const int n = sectionsBefore<SECTIONS>();
+    const int last = n * 2 + 1;
+    outboundHeld = true;
+
+    // the sections packed up against the end of the lane stay, everything behind them moves forward one
+    int queued = 0;
+    while (queued < n + 1 && at<SECTIONS>(last - queued) != NO_VEHICLE)
+        queued++;
+    if (queued >= n)
+        return; // nothing behind them but (at most) the section at numSectionsBefore + 1, which can't move
+
+    // as in advanceApproach: step the head back, then shift the packed sections back to where they were
+    head = (head == 0 ? n : head - 1);
+    if (queued > 0)
+    {
+        VehicleIndex end = at<SECTIONS>(n + 1);
+        for (int i = last - queued + 1; i < last; i++)
+            at<SECTIONS>(i) = at<SECTIONS>(i + 1);
+        at<SECTIONS>(last) = end;
+    }
+    at<SECTIONS>(n + 1) = NO_VEHICLE;
+}
+
+template <int SECTIONS>
+int Lane::advanceApproach()
+{
+    const int n = sectionsBefore<SECTIONS>();
+
+    // the queue: sections occupied all the way from the intersection back;
+    // it cannot move, everything behind it moves forward one section
+    int queued = 0;
+    while (queued < n && at<SECTIONS>(n - 1 - queued) != NO_VEHICLE)
+        queued++;
+    if (queued >= n - 1)
+        return queued; // nothing behind the queue but (at most) an empty first section
+
+    // stepping the head back one slot moves every section forward and wraps
+    // the one at the intersection around to index 0...
+    approachHead = (approachHead == 0 ? n - 1 : approachHead - 1);
+    // ...so shift the queue (if any) back to where it was, into the gap behind it
+    if (queued > 0)
+    {
+        VehicleIndex front = at<SECTIONS>(0);
+        for (int i = n - queued; i < n - 1; i++)
+            at<SECTIONS>(i) = at<SECTIONS>(i + 1);
+        at<SECTIONS>(n - 1) = front;
+    }
+    at<SECTIONS>(0) = NO_VEHICLE;
+    return queued;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __LANE_VEHICLES_CPP__
+#define __LANE_VEHICLES_CPP__
+
+#include "LaneVehicles.h"
+
+using namespace::std;
+
+//======================================================================
+//* LaneVehicles
+//======================================================================
+LaneVehicles::LaneVehicles() : storage(nullptr), context(nullptr), lookup(&LaneVehicles::none)
+{
+
+}
+
+LaneVehicles::LaneVehicles(const vector<VehicleBase*>& vehicles)
+    : storage(&vehicles), context(nullptr), lookup(&LaneVehicles::inVector)
+{
+
+}
+
+LaneVehicles::LaneVehicles(const void* storage, void* context, VehicleBase* (*lookup)(const void*, void*, int))
+    : storage(storage), context(context), lookup(lookup)
+{
+
+}
+
+VehicleBase* LaneVehicles::inVector(const void* storage, void*, int section)
+{
+    return (*static_cast<const vector<VehicleBase*>*>(storage))[section];
+}
+
+VehicleBase* LaneVehicles::none(const void*, void*, int)
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef __LANE_VEHICLES_H__
+#define __LANE_VEHICLES_H__
+
+#include <vector>
+#include "VehicleBase.h"
+
+// A lane as the Animator reads it, without owning or copying it: section i
+// holds the vehicle lookup(storage, context, i) returns (nullptr if the
+// section is empty). Views are two pointers and a function pointer, so
+// they are built and passed by value every frame for free.
+class LaneVehicles
+{
+   private:
+      const void* storage;
+      void* context;
+      VehicleBase* (*lookup)(const void* storage, void* context, int section);
+
+      static VehicleBase* inVector(const void* storage, void* context, int section);
+      static VehicleBase* none(const void* storage, void* context, int section);
+
+   public:
+      // an empty lane
+      LaneVehicles();
+      // the vehicles in a vector, one per section (the vector must outlive the view)
+      LaneVehicles(const std::vector<VehicleBase*>& vehicles);
+      LaneVehicles(std::vector<VehicleBase*>&& vehicles) = delete;
+      // any other storage
+      LaneVehicles(const void* storage, void* context, VehicleBase* (*lookup)(const void*, void*, int));
+
+      inline VehicleBase* operator[](int section) const { return lookup(storage, context, section); }
+};
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef __METRICS_CPP__
+#define __METRICS_CPP__
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include "Checkpoint.h"
+#include "Metrics.h"
+
+using namespace::std;
+
+static const char* const DIRECTION_NAMES[] = {"north", "south", "east", "west"};
+static const char* const TYPE_NAMES[] = {"cars", "SUVs", "trucks"};
+static const char* const TURN_NAMES[] = {"left", "right", "straight"};
+
+TrafficCounters::TrafficCounters()
+{
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            arrivals[d][t] = 0;
+            blockedArrivals[d][t] = 0;
+            departures[d][t] = 0;
+            leftTurnsHeld[d][t] = 0;
+        }
+        queueSectionTicks[d] = 0;
+        maxQueue[d] = 0;
+    }
+    ticks = 0;
+}
+
+void TrafficCounters::add(const TrafficCounters& other)
+{
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            arrivals[d][t] += other.arrivals[d][t];
+            blockedArrivals[d][t] += other.blockedArrivals[d][t];
+            departures[d][t] += other.departures[d][t];
+            leftTurnsHeld[d][t] += other.leftTurnsHeld[d][t];
+        }
+        queueSectionTicks[d] += other.queueSectionTicks[d];
+        maxQueue[d] = max(maxQueue[d], other.maxQueue[d]);
+    }
+    ticks += other.ticks;
+}
+
+long long TrafficCounters::total(const long long (&counts)[4][3], Direction d) const
+{
+    int dirInt = static_cast<int>(d);
+    return counts[dirInt][0] + counts[dirInt][1] + counts[dirInt][2];
+}
+
+void TrafficCounters::save(CheckpointWriter& out) const
+{
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            out.put64(arrivals[d][t]);
+            out.put64(blockedArrivals[d][t]);
+            out.put64(departures[d][t]);
+            out.put64(leftTurnsHeld[d][t]);
+        }
+        out.put64(queueSectionTicks[d]);
+        out.put32(maxQueue[d]);
+    }
+    out.put64(ticks);
+}
+
+void TrafficCounters::restore(CheckpointReader& in)
+{
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            arrivals[d][t] = in.get64();
+            blockedArrivals[d][t] = in.get64();
+            departures[d][t] = in.get64();
+            leftTurnsHeld[d][t] = in.get64();
+        }
+        queueSectionTicks[d] = in.get64();
+        maxQueue[d] = in.get32();
+    }
+    ticks = in.get64();
+}
+
+TickHistogram::TickHistogram() : total(0), maxValue(0)
+{
+
+}
+
+int TickHistogram::bucketOf(int value)
+{
+    if (value < 2 * SUB_BUCKETS)
+        return value;
+    // value has its highest bit at 2^exponent, exponent > SUB_BUCKET_BITS; keep the
+    // SUB_BUCKET_BITS bits below it
+    int exponent = SUB_BUCKET_BITS + 1;
+    while ((value >> (exponent + 1)) != 0)
+        exponent++;
+    int shift = exponent - SUB_BUCKET_BITS;
+    return 2 * SUB_BUCKETS + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+long long TickHistogram::lowestValueOf(int bucket)
+{
+    if (bucket < 2 * SUB_BUCKETS)
+        return bucket;
+    int exponent = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+    int subBucket = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    return static_cast<long long>(SUB_BUCKETS + subBucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+void TickHistogram::record(int value)
+{
+    if (value < 0)
+        value = 0;
+    int bucket = bucketOf(value);
+    if (bucket >= static_cast<int>(counts.size()))
+        counts.resize(bucket + 1, 0);
+    counts[bucket]++;
+    total++;
+    maxValue = max(maxValue, value);
+}
+
+void TickHistogram::merge(const TickHistogram& other)
+{
+    if (other.counts.size() > counts.size())
+        counts.resize(other.counts.size(), 0);
+    for (size_t b = 0; b < other.counts.size(); b++)
+        counts[b] += other.counts[b];
+    total += other.total;
+    maxValue = max(maxValue, other.maxValue);
+}
+
+int TickHistogram::quantile(double q) const
+{
+    if (total == 0)
+        return 0;
+    // rank of the value wanted, 1-based
+    long long rank = static_cast<long long>(q * total);
+    if (rank < q * total || rank == 0)
+        rank++;
+    long long seen = 0;
+    for (size_t b = 0; b < counts.size(); b++)
+    {
+        seen += counts[b];
+        if (seen >= rank)
+        {
+            // middle of the bucket, but never past the largest value recorded
+            long long low = lowestValueOf(b);
+            long long high = lowestValueOf(b + 1) - 1;
+            return static_cast<int>(min(low + (high - low) / 2, static_cast<long long>(maxValue)));
+        }
+    }
+    return maxValue;
+}
+
+void TickHistogram::save(CheckpointWriter& out) const
+{
+    // most buckets are empty: write the bucket count, then each bucket
+    // that isn't as the gap from the previous one and its count
+    int used = count_if(counts.begin(), counts.end(), [](long long count) { return count != 0; });
+    out.putVarint(counts.size());
+    out.putVarint(used);
+    int previous = -1;
+    for (int bucket = 0; bucket < static_cast<int>(counts.size()); bucket++)
+    {
+        if (counts[bucket] == 0)
+            continue;
+        out.putVarint(bucket - previous);
+        out.putVarint(counts[bucket]);
+        previous = bucket;
+    }
+    out.putVarint(total);
+    out.putVarint(maxValue);
+}
+
+void TickHistogram::restore(CheckpointReader& in)
+{
+    counts.assign(in.getVarint(), 0);
+    int used = in.getVarint();
+    int bucket = -1;
+    for (int i = 0; i < used; i++)
+    {
+        bucket += in.getVarint();
+        if (bucket < 0 || bucket >= static_cast<int>(counts.size()))
+            in.fail("bad trip time histogram");
+        counts[bucket] = in.getVarint();
+    }
+    total = in.getVarint();
+    maxValue = in.getVarint();
+}
+
+void TripTimes::record(Direction d, Turn turn, int travelTicks, int delayTicks)
+{
+    int dirInt = static_cast<int>(d);
+    int turnInt = static_cast<int>(turn);
+    travel[dirInt][turnInt].record(travelTicks);
+    delay[dirInt][turnInt].record(delayTicks);
+}
+
+void TripTimes::merge(const TripTimes& other)
+{
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            travel[d][t].merge(other.travel[d][t]);
+            delay[d][t].merge(other.delay[d][t]);
+        }
+    }
+}
+
+void TripTimes::save(CheckpointWriter& out) const
+{
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            travel[d][t].save(out);
+            delay[d][t].save(out);
+        }
+    }
+}
+
+void TripTimes::restore(CheckpointReader& in)
+{
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            travel[d][t].restore(in);
+            delay[d][t].restore(in);
+        }
+    }
+}
+
+MetricsSeries::MetricsSeries(int interval) : interval(max(1, interval))
+{
+
+}
+
+void MetricsSeries::start(const TrafficCounters& totals)
+{
+    previous = totals;
+}
+
+void MetricsSeries::afterTick(int tick, const TrafficCounters& totals)
+{
+    if (!wantsSample(tick))
+        return;
+
+    MetricsSample sample;
+    sample.tick = tick;
+    long long ticks = totals.ticks - previous.ticks;
+    for (int d = 0; d < 4; d++)
+    {
+        Direction direction = static_cast<Direction>(d);
+        sample.arrivals[d] = totals.total(totals.arrivals, direction) - previous.total(previous.arrivals, direction);
+        sample.blockedArrivals[d] = totals.total(totals.blockedArrivals, direction) - previous.total(previous.blockedArrivals, direction);
+        sample.departures[d] = totals.total(totals.departures, direction) - previous.total(previous.departures, direction);
+        sample.leftTurnsHeld[d] = totals.total(totals.leftTurnsHeld, direction) - previous.total(previous.leftTurnsHeld, direction);
+        sample.meanQueue[d] = ticks > 0 ? static_cast<double>(totals.queueSectionTicks[d] - previous.queueSectionTicks[d]) / ticks : 0;
+    }
+    samples.push_back(sample);
+    previous = totals;
+}
+
+// one counter's row (all types) and its split by type
+static void printCounter(ostream& out, const string& name, const TrafficCounters& counters, const long long (&counts)[4][3])
+{
+    out << left << setw(24) << name << right;
+    for (int d = 0; d < 4; d++)
+        out << setw(12) << counters.total(counts, static_cast<Direction>(d));
+    out << endl;
+    for (int t = 0; t < 3; t++)
+    {
+        out << left << setw(24) << string("  ") + TYPE_NAMES[t] << right;
+        for (int d = 0; d < 4; d++)
+            out << setw(12) << counts[d][t];
+        out << endl;
+    }
+}
+
+void printMetricsSummary(const TrafficCounters& counters, ostream& out)
+{
+    out << left << setw(24) << "traffic by lane" << right;
+    for (int d = 0; d < 4; d++)
+        out << setw(12) << string(DIRECTION_NAMES[d]) + "bound";
+    out << endl;
+
+    printCounter(out, "arrivals", counters, counters.arrivals);
+    printCounter(out, "blocked arrivals", counters, counters.blockedArrivals);
+    printCounter(out, "departures", counters, counters.departures);
+    printCounter(out, "left turns held", counters, counters.leftTurnsHeld);
+
+    out << left << setw(24) << "mean queue (sections)" << right << fixed << setprecision(2);
+    for (int d = 0; d < 4; d++)
+        out << setw(12) << (counters.ticks > 0 ? static_cast<double>(counters.queueSectionTicks[d]) / counters.ticks : 0.0);
+    out << endl;
+    out.unsetf(ios::fixed);
+    out << setprecision(6);
+
+    out << left << setw(24) << "max queue (sections)" << right;
+    for (int d = 0; d < 4; d++)
+        out << setw(12) << counters.maxQueue[d];
+    out << endl;
+}
+
+void printTripTimes(const TripTimes& trips, ostream& out)
+{
+    out << left << setw(24) << "trip ticks by lane" << right << setw(10) << "vehicles"
+        << setw(8) << "p50" << setw(8) << "p95" << setw(8) << "p99"
+        << setw(10) << "delay p50" << setw(8) << "p95" << setw(8) << "p99" << endl;
+    for (int d = 0; d < 4; d++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            const TickHistogram& travel = trips.travel[d][t];
+            const TickHistogram& delay = trips.delay[d][t];
+            out << left << setw(24) << string(DIRECTION_NAMES[d]) + "bound " + TURN_NAMES[t] << right
+                << setw(10) << travel.getCount()
+                << setw(8) << travel.quantile(0.50) << setw(8) << travel.quantile(0.95) << setw(8) << travel.quantile(0.99)
+                << setw(10) << delay.quantile(0.50) << setw(8) << delay.quantile(0.95) << setw(8) << delay.quantile(0.99) << endl;
+        }
+    }
+}
+
+void writeMetricsSeries(const vector<MetricsSample>& samples, ostream& out)
+{
+    out << "tick";
+    for (int d = 0; d < 4; d++)
+        out << ",arrivals_" << DIRECTION_NAMES[d] << ",blocked_" << DIRECTION_NAMES[d] << ",departures_" << DIRECTION_NAMES[d]
+            << ",left_held_" << DIRECTION_NAMES[d] << ",mean_queue_" << DIRECTION_NAMES[d];
+    out << "\n";
+
+    for (const MetricsSample& sample : samples)
+    {
+        out << sample.tick;
+        for (int d = 0; d < 4; d++)
+            out << "," << sample.arrivals[d] << "," << sample.blockedArrivals[d] << "," << sample.departures[d]
+                << "," << sample.leftTurnsHeld[d] << "," << sample.meanQueue[d];
+        out << "\n";
+    }
+}
+
+#endif
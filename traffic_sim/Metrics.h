@@ -0,0 +1,135 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <ostream>
+#include <vector>
+#include "VehicleBase.h"
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// Plain counters an intersection bumps as it steps (always on, so every
+// update is a single increment). Counts are indexed by the lane's Direction
+// and, where the vehicle matters, by VehicleType (car, suv, truck).
+struct TrafficCounters
+{
+    long long arrivals[4][3];        // vehicles that entered the start of the lane
+    long long blockedArrivals[4][3]; // vehicles generated while the start of the lane was taken (they are lost)
+    long long departures[4][3];      // vehicles whose last section left the end of the lane
+    long long leftTurnsHeld[4][3];   // ticks a left turn waited at the stop line because the gap check found oncoming traffic
+    long long queueSectionTicks[4];  // sections waiting at the stop line (packed back from it), summed over ticks
+    int maxQueue[4];                 // longest queue ever (sections)
+    long long ticks;                 // ticks stepped, summed over the intersections added together
+
+    TrafficCounters();
+
+    // add another intersection's counters (maxQueue keeps the larger; ticks
+    // add up, so queueSectionTicks / ticks stays the mean queue of one lane)
+    void add(const TrafficCounters& other);
+
+    // sum over vehicle types
+    long long total(const long long (&counts)[4][3], Direction d) const;
+
+    void save(CheckpointWriter& out) const;
+    void restore(CheckpointReader& in);
+};
+
+// Streaming histogram of tick counts in the style of an HDR histogram:
+// values below 2 * SUB_BUCKETS get a bucket each, and every power of two
+// above that is split into SUB_BUCKETS equal buckets, so a quantile is
+// never off by more than 1/SUB_BUCKETS of its value. Memory depends only
+// on the largest value recorded (at most a few hundred buckets for any
+// int), not on how many values were recorded, and two histograms merge by
+// adding their buckets.
+class TickHistogram
+{
+   private:
+      static const int SUB_BUCKET_BITS = 5;
+      static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+      std::vector<long long> counts; // grows up to the bucket of the largest value
+      long long total;
+      int maxValue;
+
+      static int bucketOf(int value);
+      static long long lowestValueOf(int bucket);
+
+   public:
+      TickHistogram();
+
+      void record(int value); // negative values count as 0
+      void merge(const TickHistogram& other);
+
+      // smallest recorded value v (to within a bucket) with at least
+      // fraction q of the values <= v; 0 if nothing was recorded
+      int quantile(double q) const;
+
+      inline long long getCount() const { return total; }
+      inline int getMax() const { return maxValue; }
+
+      void save(CheckpointWriter& out) const;
+      void restore(CheckpointReader& in);
+};
+
+// travel time and delay of every vehicle that left a lane, by the lane's
+// Direction and the vehicle's Turn (left, right, straight)
+struct TripTimes
+{
+    TickHistogram travel[4][3]; // ticks from entering the lane to leaving it
+    TickHistogram delay[4][3];  // ticks beyond an unimpeded trip through the lane
+
+    void record(Direction d, Turn turn, int travelTicks, int delayTicks);
+    void merge(const TripTimes& other);
+
+    void save(CheckpointWriter& out) const;
+    void restore(CheckpointReader& in);
+};
+
+// totals over one interval of the time series
+struct MetricsSample
+{
+    int tick;                 // last tick of the interval
+    long long arrivals[4];
+    long long blockedArrivals[4];
+    long long departures[4];
+    long long leftTurnsHeld[4];
+    double meanQueue[4];      // sections waiting at the stop line, per intersection
+};
+
+// Turns running totals into a time series: every interval ticks, the
+// change in each counter since the previous sample.
+class MetricsSeries
+{
+   private:
+      int interval;
+      TrafficCounters previous;
+      std::vector<MetricsSample> samples;
+
+   public:
+      MetricsSeries(int interval);
+
+      // the totals the first interval counts from (a resumed run's restored counters)
+      void start(const TrafficCounters& totals);
+
+      // whether afterTick(tick, ...) takes a sample; check it first, since
+      // gathering the totals of a network visits every intersection
+      inline bool wantsSample(int tick) const { return (tick + 1) % interval == 0; }
+
+      // called after every tick with the totals so far
+      void afterTick(int tick, const TrafficCounters& totals);
+
+      inline const std::vector<MetricsSample>& getSamples() const { return samples; }
+};
+
+// end of run report: one row per counter, one column per direction, each
+// counter followed by its split by vehicle type
+void printMetricsSummary(const TrafficCounters& counters, std::ostream& out);
+
+// end of run report: p50, p95 and p99 travel time and delay for each lane
+// and turn
+void printTripTimes(const TripTimes& trips, std::ostream& out);
+
+// the time series as CSV, one row per sample
+void writeMetricsSeries(const std::vector<MetricsSample>& samples, std::ostream& out);
+
+#endif
@@ -0,0 +1,372 @@
+#ifndef __NETWORK_CPP__
+#define __NETWORK_CPP__
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <map>
+#include "Checkpoint.h"
+#include "Network.h"
+
+using namespace::std;
+
+NetworkLayout singleIntersectionLayout(const SimulationConfig& config)
+{
+    NetworkLayout layout;
+    layout.rows = 1;
+    layout.columns = 1;
+    layout.timings.push_back({config.green_north_south, config.yellow_north_south,
+        config.green_east_west, config.yellow_east_west});
+    return layout;
+}
+
+NetworkLayout readNetworkLayout(const string& fileName, const SimulationConfig& config)
+{
+    map<string, double> network_dict = readKeyValueFile(fileName);
+
+    NetworkLayout layout = singleIntersectionLayout(config);
+    layout.rows = network_dict["rows"];
+    layout.columns = network_dict["columns"];
+    if (layout.rows < 1 || layout.columns < 1)
+    {
+        cerr << "Network file " << fileName << " must give rows and columns of at least 1" << endl;
+        exit(0);
+    }
+    layout.timings.assign(layout.rows * layout.columns, layout.timings[0]);
+
+    for (int r = 0; r < layout.rows; r++)
+    {
+        for (int c = 0; c < layout.columns; c++)
+        {
+            string prefix = "r" + to_string(r) + "c" + to_string(c) + ".";
+            SignalTiming& timing = layout.timings[r * layout.columns + c];
+            if (network_dict.count(prefix + "green_north_south"))
+                timing.green_north_south = network_dict[prefix + "green_north_south"];
+            if (network_dict.count(prefix + "yellow_north_south"))
+                timing.yellow_north_south = network_dict[prefix + "yellow_north_south"];
+            if (network_dict.count(prefix + "green_east_west"))
+                timing.green_east_west = network_dict[prefix + "green_east_west"];
+            if (network_dict.count(prefix + "yellow_east_west"))
+                timing.yellow_east_west = network_dict[prefix + "yellow_east_west"];
+        }
+    }
+    return layout;
+}
+
+// seed for the random number stream of the intersection at index k
+static unsigned int intersectionSeed(unsigned int seed, int k)
+{
+    if (k == 0)
+        return seed;
+    seed_seq sequence {seed, static_cast<unsigned int>(k)};
+    unsigned int derived;
+    sequence.generate(&derived, &derived + 1);
+    return derived;
+}
+
+Network::Network(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed)
+    : Network(config, layout, seed, 0, layout.rows - 1)
+{
+
+}
+
+Network::Network(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed, int firstRow, int lastRow)
+    : rows(layout.rows), columns(layout.columns), firstRow(firstRow), lastRow(lastRow), pool(nullptr)
+{
+    // numbered as in the whole network, so seeds and vehicle IDs don't depend on the region
+    for (int k = firstRow * columns; k < (lastRow + 1) * columns; k++)
+        intersections.push_back(unique_ptr<Intersection>(
+            new Intersection(config, layout.timings[k], k, rows * columns, intersectionSeed(seed, k))));
+
+    // lanes heading off the grid end the network there; the approaches they would have fed
+    // on the opposite side of the grid are the ones that generate arrivals
+    for (int r = firstRow; r <= lastRow; r++)
+    {
+        for (int c = 0; c < columns; c++)
+        {
+            Intersection& intersection = at(r, c);
+            intersection.setFeedsNeighbour(Direction::north, r > 0);
+            intersection.setFeedsNeighbour(Direction::south, r < rows - 1);
+            intersection.setFeedsNeighbour(Direction::east, c < columns - 1);
+            intersection.setFeedsNeighbour(Direction::west, c > 0);
+            intersection.setGeneratesArrivals(Direction::north, r == rows - 1);
+            intersection.setGeneratesArrivals(Direction::south, r == 0);
+            intersection.setGeneratesArrivals(Direction::east, c == 0);
+            intersection.setGeneratesArrivals(Direction::west, c == columns - 1);
+        }
+    }
+}
+
+void Network::step(int tick)
+{
+    if (pool == nullptr)
+    {
+        for (unique_ptr<Intersection>& intersection : intersections)
+            intersection->step(tick);
+        collectBoundary();
+        exchange();
+        return;
+    }
+
+    forEachRange([this, tick](int begin, int end)
+    {
+        for (int k = begin; k < end; k++)
+            intersections[k]->step(tick);
+    });
+    collectBoundary();
+    forEachRange([this](int begin, int end)
+    {
+        for (int k = begin; k < end; k++)
+            collect(k);
+    });
+}
+
+void Network::setThreadPool(ThreadPool* pool)
+{
+    this->pool = pool;
+}
+
+// run work on the pool over a few ranges of intersections per worker, and wait for all of them
+void Network::forEachRange(const function<void(int, int)>& work)
+{
+    int count = size();
+    int ranges = min(count, pool->size() * 4);
+    for (int i = 0; i < ranges; i++)
+    {
+        int begin = static_cast<long long>(count) * i / ranges;
+        int end = static_cast<long long>(count) * (i + 1) / ranges;
+        pool->submit([&work, begin, end] { work(begin, end); });
+    }
+    pool->wait();
+}
+
+void Network::scheduleArrivals(int fromTick)
+{
+    for (unique_ptr<Intersection>& intersection : intersections)
+        intersection->scheduleArrivals(fromTick);
+}
+
+bool Network::isIdle() const
+{
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        if (!intersection->isIdle())
+            return false;
+    return true;
+}
+
+int Network::getNextArrival() const
+{
+    int next = INT_MAX;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        next = min(next, intersection->getNextArrival());
+    return next;
+}
+
+void Network::skipIdleTicks(int ticks)
+{
+    for (unique_ptr<Intersection>& intersection : intersections)
+        intersection->skipIdleTicks(ticks);
+}
+
+void Network::save(CheckpointWriter& out) const
+{
+    out.put32(rows);
+    out.put32(columns);
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        intersection->save(out);
+}
+
+void Network::restore(CheckpointReader& in)
+{
+    int savedRows = in.get32();
+    int savedColumns = in.get32();
+    if (savedRows != rows || savedColumns != columns)
+        in.fail("written for a " + to_string(savedRows) + "x" + to_string(savedColumns) + " network");
+    for (unique_ptr<Intersection>& intersection : intersections)
+        intersection->restore(in);
+}
+
+void Network::reseed(unsigned int seed, int fromTick)
+{
+    for (int k = 0; k < size(); k++)
+    {
+        int index = firstRow * columns + k;
+        intersections[k]->reseed(intersectionSeed(seed, index), index, fromTick);
+    }
+}
+
+void Network::resetStatistics()
+{
+    for (unique_ptr<Intersection>& intersection : intersections)
+        intersection->resetStatistics();
+}
+
+// deliver what from's lane d handed off to to's approach d, and tell from whether that entry queue is now full
+static void handOff(Intersection& from, Intersection& to, Direction d)
+{
+    to.receive(d, from.getOutbox(d));
+    from.setDownstreamFull(d, to.getEntryQueueLength(d) >= Intersection::ENTRY_QUEUE_CAPACITY);
+}
+
+// the parallel counterpart of exchange(): intersection k takes the sections its upstream
+// neighbours' outboxes hold (each outbox is cleared by its owner at the start of the next step);
+// only k writes to their downstreamFull flags for the lanes that feed it
+void Network::collect(int k)
+{
+    int r = firstRow + k / columns;
+    int c = k % columns;
+    Intersection& to = *intersections[k];
+    if (r < lastRow)
+        handOff(at(r + 1, c), to, Direction::north);
+    if (r > firstRow)
+        handOff(at(r - 1, c), to, Direction::south);
+    if (c > 0)
+        handOff(at(r, c - 1), to, Direction::east);
+    if (c < columns - 1)
+        handOff(at(r, c + 1), to, Direction::west);
+}
+
+// sections leaving a region through its north or south edge, for the neighbouring region
+void Network::collectBoundary()
+{
+    for (int b = 0; b < 2; b++)
+    {
+        boundaryOutboxes[b].clear();
+        boundaryQueues[b].assign(columns, 0);
+    }
+    for (int c = 0; c < columns; c++)
+    {
+        if (firstRow > 0)
+        {
+            for (const HandoffSection& section : at(firstRow, c).getOutbox(Direction::north))
+                boundaryOutboxes[0].push_back({c, section});
+            boundaryQueues[0][c] = at(firstRow, c).getEntryQueueLength(Direction::south);
+        }
+        if (lastRow < rows - 1)
+        {
+            for (const HandoffSection& section : at(lastRow, c).getOutbox(Direction::south))
+                boundaryOutboxes[1].push_back({c, section});
+            boundaryQueues[1][c] = at(lastRow, c).getEntryQueueLength(Direction::north);
+        }
+    }
+}
+
+void Network::receiveBoundary(Direction d, const vector<BoundarySection>& sections, const vector<int>& queued)
+{
+    // northbound sections come up from the region south of this one, southbound ones down from the north
+    int row = d == Direction::north ? lastRow : firstRow;
+    vector<HandoffSection> column;
+    for (size_t i = 0; i < sections.size(); )
+    {
+        int c = sections[i].column;
+        column.clear();
+        for (; i < sections.size() && sections[i].column == c; i++)
+            column.push_back(sections[i].section);
+        at(row, c).receive(d, column);
+    }
+
+    // the neighbour's queues fed by this region's lanes across the same edge, once what they sent has arrived
+    Direction out = d == Direction::north ? Direction::south : Direction::north;
+    vector<int> lengths = queued;
+    for (const BoundarySection& sent : getBoundaryOutbox(out))
+        lengths[sent.column]++;
+    for (int c = 0; c < columns; c++)
+        at(row, c).setDownstreamFull(out, lengths[c] >= Intersection::ENTRY_QUEUE_CAPACITY);
+}
+
+void Network::exchange()
+{
+    for (int r = firstRow; r <= lastRow; r++)
+    {
+        for (int c = 0; c < columns; c++)
+        {
+            Intersection& from = at(r, c);
+            if (r > firstRow)
+                handOff(from, at(r - 1, c), Direction::north);
+            if (r < lastRow)
+                handOff(from, at(r + 1, c), Direction::south);
+            if (c < columns - 1)
+                handOff(from, at(r, c + 1), Direction::east);
+            if (c > 0)
+                handOff(from, at(r, c - 1), Direction::west);
+
+            for (int d = 0; d < 4; d++)
+                from.getOutbox(static_cast<Direction>(d)).clear();
+        }
+    }
+}
+
+int Network::getExitCount(Direction d) const
+{
+    int total = 0;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total += intersection->getExitCount(d);
+    return total;
+}
+
+int Network::getVehicleCount() const
+{
+    int total = 0;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total += intersection->getVehicles().getVehicleCount();
+    return total;
+}
+
+int Network::getRowsInUse() const
+{
+    int total = 0;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total += intersection->getVehicles().getInUse();
+    return total;
+}
+
+int Network::getHighWaterMarks() const
+{
+    int total = 0;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total += intersection->getVehicles().getHighWaterMark();
+    return total;
+}
+
+long long Network::getCompletedVehicles() const
+{
+    long long total = 0;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total += intersection->getCompletedVehicles();
+    return total;
+}
+
+long long Network::getTotalTravelTicks() const
+{
+    long long total = 0;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total += intersection->getTotalTravelTicks();
+    return total;
+}
+
+long long Network::getTotalDelayTicks() const
+{
+    long long total = 0;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total += intersection->getTotalDelayTicks();
+    return total;
+}
+
+TrafficCounters Network::getCounters() const
+{
+    TrafficCounters total;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total.add(intersection->getCounters());
+    return total;
+}
+
+TripTimes Network::getTripTimes() const
+{
+    TripTimes total;
+    for (const unique_ptr<Intersection>& intersection : intersections)
+        total.merge(intersection->getTripTimes());
+    return total;
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef __NETWORK_H__
+#define __NETWORK_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "Intersection.h"
+#include "ThreadPool.h"
+
+// Shape of the road network: a grid of rows x columns intersections, row 0
+// the northernmost and column 0 the westernmost, plus the signal timing of
+// each intersection (row-major).
+struct NetworkLayout
+{
+    int rows;
+    int columns;
+    std::vector<SignalTiming> timings;
+};
+
+// a single intersection using the timing from the input file
+NetworkLayout singleIntersectionLayout(const SimulationConfig& config);
+
+// Read a network file: "key: value" lines like the input file, with
+//    rows:     R
+//    columns:  C
+// and optionally per-intersection signal timing overrides such as
+//    r0c2.green_north_south: 20
+// for any of green_north_south, yellow_north_south, green_east_west and
+// yellow_east_west (intersections without one use the input file's value).
+NetworkLayout readNetworkLayout(const std::string& fileName, const SimulationConfig& config);
+
+// a section crossing the north or south edge of a region of the network
+// (see Network's region constructor), and the column it crosses in
+struct BoundarySection
+{
+    int            column;
+    HandoffSection section;
+};
+
+// A grid of intersections chained together: the northbound lane of an
+// intersection feeds the northbound approach of the one north of it, and
+// so on for the other directions. Only approaches on the edge of the grid
+// generate arrivals, and vehicles leave the simulation only from lanes
+// that end on the edge.
+//
+// Each intersection has its own random number stream; the one at row 0,
+// column 0 is seeded with the run's seed itself, so a 1x1 network behaves
+// exactly like the original single-intersection simulation.
+//
+// A Network can also hold just a band of rows of the grid (a region, as
+// a shard of a sharded run holds; see Shards.h). Its intersections are
+// exactly the ones the whole network would have there, and the sections
+// that leave it through its north or south edge are collected in boundary
+// outboxes instead, for whoever holds the neighbouring region to deliver
+// with receiveBoundary().
+class Network
+{
+   private:
+      int rows;
+      int columns;
+      int firstRow; // the rows this network holds: all of them, or a region
+      int lastRow;
+      std::vector<std::unique_ptr<Intersection>> intersections; // row-major, from firstRow
+      ThreadPool* pool; // steps the intersections in parallel, if set
+      std::vector<BoundarySection> boundaryOutboxes[2]; // left through the north edge, the south edge
+      std::vector<int> boundaryQueues[2]; // entry queue lengths of the approaches fed across those edges
+
+      void exchange();
+      void collect(int k);
+      void collectBoundary();
+      void forEachRange(const std::function<void(int, int)>& work);
+
+   public:
+      Network(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed);
+      // only rows firstRow to lastRow of the network
+      Network(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed, int firstRow, int lastRow);
+
+      // advance every intersection by one tick, then deliver the sections
+      // that left each one to its neighbours (they enter on a later tick)
+      void step(int tick);
+
+      // Step on the pool's threads from now on (nullptr steps serially). A
+      // tick then runs in two phases, each split into ranges of
+      // intersections that idle workers steal from each other: every
+      // intersection steps, touching only its own lanes and outboxes, and
+      // once all have, every intersection collects what its upstream
+      // neighbours' outboxes hold into its entry queues (and tells each of
+      // them whether that queue is now full). Each entry queue has a single
+      // upstream neighbour, and each intersection has its own random number
+      // stream and vehicle table, so the result is the same as a serial
+      // step for any number of threads.
+      void setThreadPool(ThreadPool* pool);
+
+      // Regions: the sections that left through the north (Direction::north)
+      // or south edge on the last step, and the delivery of sections that
+      // crossed into the region's northbound approaches on its south edge
+      // (Direction::north) or its southbound approaches on its north edge,
+      // in the order they left the neighbouring region.
+      //
+      // For back-pressure, each region also passes on the entry queue
+      // lengths (one per column, as its last step left them) of the edge
+      // approaches its neighbour feeds, here those on the north edge
+      // (Direction::north) or the south edge; receiveBoundary takes the
+      // neighbour's along with its sections, and adds the sections this
+      // region sent across to tell its own edge lanes whether those queues
+      // are full, exactly as a single network's delivery would have.
+      inline const std::vector<BoundarySection>& getBoundaryOutbox(Direction d) const
+            { return boundaryOutboxes[d == Direction::north ? 0 : 1]; }
+      inline const std::vector<int>& getBoundaryQueues(Direction d) const
+            { return boundaryQueues[d == Direction::north ? 0 : 1]; }
+      void receiveBoundary(Direction d, const std::vector<BoundarySection>& sections, const std::vector<int>& queued);
+
+      // next-event mode for every intersection (see Intersection::scheduleArrivals)
+      void scheduleArrivals(int fromTick);
+      bool isIdle() const;
+      int getNextArrival() const;
+      void skipIdleTicks(int ticks);
+
+      inline Intersection& at(int row, int column) { return *intersections[(row - firstRow) * columns + column]; }
+      inline int getRows() const { return rows; }
+      inline int getColumns() const { return columns; }
+      inline int size() const { return intersections.size(); } // intersections held
+
+      // every intersection, for checkpoints (the layout must match)
+      void save(CheckpointWriter& out) const;
+      void restore(CheckpointReader& in);
+
+      // give every intersection the streams a network built with this seed
+      // would have (see Intersection::reseed)
+      void reseed(unsigned int seed, int fromTick);
+      // see Intersection::resetStatistics
+      void resetStatistics();
+
+      // totals over all intersections; the vehicle table rows are summed
+      // table by table, so a vehicle straddling two intersections holds a
+      // row in each, and the sum of the tables' peaks is not one network
+      // peak
+      int getExitCount(Direction d) const;
+      int getVehicleCount() const;
+      int getRowsInUse() const;
+      int getHighWaterMarks() const;
+      long long getCompletedVehicles() const;
+      long long getTotalTravelTicks() const;
+      long long getTotalDelayTicks() const;
+      TrafficCounters getCounters() const;
+      TripTimes getTripTimes() const;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef __PLAYBACK_CPP__
+#define __PLAYBACK_CPP__
+
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "Playback.h"
+
+using namespace::std;
+
+// terminal settings from before raw mode, put back on exit or when a signal
+// would otherwise leave the shell without echo
+static struct termios savedTerminal;
+
+static void restoreTerminal(int signalNumber)
+{
+    tcsetattr(STDIN_FILENO, TCSANOW, &savedTerminal);
+    signal(signalNumber, SIG_DFL);
+    raise(signalNumber);
+}
+
+Playback::Playback(SimulationRun& run, const function<void(int)>& drawFrame,
+                   const function<void(int)>& afterTick, const PlaybackOptions& options)
+    : run(run), drawFrame(drawFrame), afterTick(afterTick), options(options),
+      speed(1), paused(false), quit(false), inputOpen(true), rawMode(false)
+{
+    if (this->options.renderEvery < 1)
+        this->options.renderEvery = 1;
+
+    // keys arrive one at a time without echo, and Ctrl-C still works
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &savedTerminal) == 0)
+    {
+        struct termios raw = savedTerminal;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        signal(SIGINT, restoreTerminal);
+        signal(SIGTERM, restoreTerminal);
+        rawMode = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+}
+
+Playback::~Playback()
+{
+    if (rawMode)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &savedTerminal);
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+    }
+}
+
+void Playback::play()
+{
+    chrono::duration<double> period(1.0 / options.fps);
+    chrono::steady_clock::time_point nextFrame = chrono::steady_clock::now();
+
+    while (!run.finished() && !quit)
+    {
+        if (paused)
+        {
+            handleKey(readKey(-1));
+            continue;
+        }
+
+        nextFrame += chrono::duration_cast<chrono::steady_clock::duration>(period);
+
+        // simulate this frame's ticks, then draw the last of them
+        int last = -1;
+        if (speed == MAX_SPEED)
+        {
+            do
+                last = stepTicks(options.renderEvery);
+            while (!run.finished() && chrono::steady_clock::now() < nextFrame);
+            handleKey(readKey(0));
+        }
+        else
+            last = stepTicks(options.renderEvery * speed);
+        if (last >= 0)
+            drawFrame(last);
+
+        // wait out the rest of the frame, handling keys as they arrive
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        while (speed != MAX_SPEED && !paused && !quit && now < nextFrame)
+        {
+            int wait = chrono::duration_cast<chrono::milliseconds>(nextFrame - now).count() + 1;
+            handleKey(readKey(wait));
+            now = chrono::steady_clock::now();
+        }
+
+        // a frame that ran long (or a pause) shouldn't be made up for with
+        // a burst of frames afterwards
+        if (now > nextFrame + period)
+            nextFrame = now;
+    }
+}
+
+int Playback::stepTicks(int count)
+{
+    // returns the last tick simulated, -1 if the run was already finished
+    int last = -1;
+    for (int i = 0; i < count && !run.finished(); i++)
+    {
+        last = run.getTick();
+        run.step();
+        if (afterTick)
+            afterTick(last);
+    }
+    return last;
+}
+
+int Playback::readKey(int timeoutMilliseconds)
+{
+    // returns the key pressed, or -1 if none arrived within the timeout
+    // (-1 waits indefinitely)
+    if (!inputOpen)
+    {
+        if (timeoutMilliseconds > 0)
+            this_thread::sleep_for(chrono::milliseconds(timeoutMilliseconds));
+        return -1;
+    }
+
+    struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+    if (poll(&input, 1, timeoutMilliseconds) <= 0)
+        return -1;
+
+    unsigned char key;
+    if (read(STDIN_FILENO, &key, 1) != 1)
+    {
+        inputOpen = false;
+        paused = false; // nothing could ever resume it
+        return -1;
+    }
+    return key;
+}
+
+void Playback::handleKey(int key)
+{
+    switch (key)
+    {
+        case ' ':
+        case 'p':
+            paused = !paused;
+            break;
+        case 's':
+        {
+            paused = true;
+            int last = stepTicks(1);
+            if (last >= 0)
+                drawFrame(last);
+            break;
+        }
+        case '1': speed = 1;  break;
+        case '2': speed = 2;  break;
+        case '0': speed = 10; break;
+        case 'm': speed = MAX_SPEED; break;
+        case 'q': quit = true; break;
+        default: break;
+    }
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __PLAYBACK_H__
+#define __PLAYBACK_H__
+
+#include <functional>
+#include "SimulationRun.h"
+
+// how a paced playback runs (from --fps and --render-every)
+struct PlaybackOptions
+{
+    double fps;      // frames drawn per second
+    int renderEvery; // ticks simulated per frame at 1x speed
+};
+
+// Plays a run back at a steady frame rate instead of waiting for Enter. A
+// monotonic clock schedules the frames, and the keyboard is read without
+// blocking (the terminal is put in raw mode while playing):
+//    space or p   pause / resume
+//    s            simulate and draw one tick (pauses first if playing)
+//    1, 2, 0      1x, 2x or 10x speed: renderEvery, 2x or 10x as many ticks per frame
+//    m            maximum speed: simulate flat out, drawing a frame every 1/fps seconds
+//    q            stop the run
+class Playback
+{
+   private:
+      static const int MAX_SPEED = 0;
+
+      SimulationRun& run;
+      std::function<void(int)> drawFrame; // draws the state after the given tick
+      std::function<void(int)> afterTick; // called after every tick, drawn or not
+      PlaybackOptions options;
+      int speed;        // multiplier on renderEvery, or MAX_SPEED
+      bool paused;
+      bool quit;
+      bool inputOpen;   // false once stdin reaches end of file
+      bool rawMode;     // stdin is a terminal we switched to raw mode
+
+      int stepTicks(int count);
+      int readKey(int timeoutMilliseconds);
+      void handleKey(int key);
+
+   public:
+      Playback(SimulationRun& run, const std::function<void(int)>& drawFrame,
+               const std::function<void(int)>& afterTick, const PlaybackOptions& options);
+      Playback(const Playback& other) = delete;
+      Playback& operator=(const Playback& other) = delete;
+      ~Playback();
+
+      // play until the run finishes or q is pressed
+      void play();
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef __RENDER_THREAD_CPP__
+#define __RENDER_THREAD_CPP__
+
+#include <chrono>
+#include "Animator.h"
+#include "RenderThread.h"
+
+using namespace::std;
+
+//======================================================================
+//* FrameTripleBuffer
+//======================================================================
+FrameTripleBuffer::FrameTripleBuffer() : back(0), front(1), latest(2)
+{
+
+}
+
+void FrameTripleBuffer::publish(int tick, Intersection& intersection)
+{
+    captureFrame(tick, intersection, frames[back]);
+    // release: the capture is visible to whoever takes this frame; acquire:
+    // the consumer is done with the frame we get back, if it was its front
+    back = latest.exchange(back | FRESH, memory_order_acq_rel) & ~FRESH;
+}
+
+const TraceFrame* FrameTripleBuffer::takeNewest()
+{
+    if ((latest.load(memory_order_relaxed) & FRESH) == 0)
+        return nullptr;
+    front = latest.exchange(front, memory_order_acq_rel) & ~FRESH;
+    return &frames[front];
+}
+
+//======================================================================
+//* RenderThread
+//======================================================================
+RenderThread::RenderThread(int numSectionsBefore) : numSectionsBefore(numSectionsBefore), finishing(false)
+{
+    renderer = thread(&RenderThread::renderLoop, this);
+}
+
+RenderThread::~RenderThread()
+{
+    finish();
+}
+
+void RenderThread::finish()
+{
+    if (!renderer.joinable())
+        return;
+    finishing.store(true, memory_order_release);
+    renderer.join();
+}
+
+void RenderThread::renderLoop()
+{
+    Animator animator(numSectionsBefore);
+    vector<VehicleBase*> lanes[4]; // reused, so only the first frame sizes them
+    while (true)
+    {
+        // read before looking for a frame, so the last frame published before finish() is drawn
+        bool last = finishing.load(memory_order_acquire);
+        if (const TraceFrame* frame = frames.takeNewest())
+        {
+            VehicleTable table;
+            frameLanes(*frame, numSectionsBefore, table, lanes);
+            animator.setLightNorthSouth(frame->northSouthLight);
+            animator.setLightEastWest(frame->eastWestLight);
+            animator.setVehiclesNorthbound(lanes[static_cast<int>(Direction::north)]);
+            animator.setVehiclesWestbound(lanes[static_cast<int>(Direction::west)]);
+            animator.setVehiclesSouthbound(lanes[static_cast<int>(Direction::south)]);
+            animator.setVehiclesEastbound(lanes[static_cast<int>(Direction::east)]);
+            animator.draw(frame->tick);
+        }
+        else if (last)
+            return;
+        else
+            this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+#endif
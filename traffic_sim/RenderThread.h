@@ -0,0 +1,71 @@
+#ifndef __RENDER_THREAD_H__
+#define __RENDER_THREAD_H__
+
+#include <atomic>
+#include <thread>
+#include "Intersection.h"
+#include "Trace.h"
+
+// Triple buffer for handing what to draw from the simulation thread to
+// the render thread with no locks. Each of the three frames belongs to
+// exactly one party at a time: the producer's back frame, which it
+// captures into; the consumer's front frame, which it draws from; and the
+// latest frame published, whose index (with a bit saying whether it has
+// been taken yet) is the only shared state. Publishing swaps the back
+// frame for the latest and taking swaps the front frame for it, each with
+// one atomic exchange, so neither side ever touches a frame the other
+// may be using. The producer never waits: a frame published before the
+// consumer took the previous one replaces it (that one is dropped).
+class FrameTripleBuffer
+{
+   private:
+      static const unsigned FRESH = 4; // with the index in latest: published and not taken yet
+
+      TraceFrame frames[3];
+      unsigned back;  // producer only
+      unsigned front; // consumer only
+      std::atomic<unsigned> latest;
+
+   public:
+      FrameTripleBuffer();
+      FrameTripleBuffer(const FrameTripleBuffer& other) = delete;
+      FrameTripleBuffer& operator=(const FrameTripleBuffer& other) = delete;
+
+      // producer: capture the intersection at the end of tick and make it the latest frame
+      void publish(int tick, Intersection& intersection);
+
+      // consumer: the newest frame published, dropping any older ones, or
+      // nullptr if nothing was published since the last take; it stays
+      // valid (and unchanged) until the next call
+      const TraceFrame* takeNewest();
+};
+
+// Draws frames on a thread of its own, so a slow terminal never holds up
+// the simulation: the tick loop publishes a snapshot of the intersection
+// whenever it has a frame to show and carries on, and the render thread
+// (which owns the Animator) draws the newest snapshot whenever it is ready
+// for another, skipping any that arrived while it was busy.
+class RenderThread
+{
+   private:
+      int numSectionsBefore;
+      FrameTripleBuffer frames;
+      std::atomic<bool> finishing;
+      std::thread renderer;
+
+      void renderLoop();
+
+   public:
+      RenderThread(int numSectionsBefore);
+      ~RenderThread(); // finish()
+      RenderThread(const RenderThread& other) = delete;
+      RenderThread& operator=(const RenderThread& other) = delete;
+
+      // show the state of the intersection at the end of tick (never blocks)
+      inline void publish(int tick, Intersection& intersection) { frames.publish(tick, intersection); }
+
+      // draw the last frame published, if it hasn't been, and stop the thread
+      void finish();
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef __REPLICATIONS_CPP__
+#define __REPLICATIONS_CPP__
+
+#include <cmath>
+#include <iomanip>
+#include <string>
+#include "Checkpoint.h"
+#include "Replications.h"
+
+using namespace::std;
+
+// two-sided 95% Student's t critical values for 1 to 30 degrees of freedom
+static const double T_CRITICAL_95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+SummaryStatistic summarize(const vector<double>& values)
+{
+    SummaryStatistic statistic = {0, 0, 0};
+    int n = values.size();
+    if (n == 0)
+        return statistic;
+
+    for (double value : values)
+        statistic.mean += value;
+    statistic.mean /= n;
+    if (n == 1)
+        return statistic;
+
+    double sumSquares = 0;
+    for (double value : values)
+        sumSquares += (value - statistic.mean) * (value - statistic.mean);
+    statistic.standardDeviation = sqrt(sumSquares / (n - 1));
+
+    double t = n - 1 <= 30 ? T_CRITICAL_95[n - 2] : 1.96;
+    statistic.halfWidth = t * statistic.standardDeviation / sqrt(n);
+    return statistic;
+}
+
+vector<RunResult> runReplications(const SimulationConfig& config, const NetworkLayout& layout,
+    unsigned int firstSeed, int replications, ThreadPool& pool, bool skipIdle, int warmupTicks)
+{
+    // warm up once, on this thread, and keep the state to branch from
+    CheckpointWriter snapshot;
+    if (warmupTicks > 0)
+    {
+        SimulationRun warmup(config, layout, firstSeed);
+        if (skipIdle)
+            warmup.enableIdleSkipping();
+        warmup.runUntil(warmupTicks);
+        warmup.save(snapshot);
+    }
+
+    vector<RunResult> results(replications);
+    for (int r = 0; r < replications; r++)
+    {
+        // each task builds its own run, so replications share nothing but the read-only config, layout and snapshot
+        pool.submit([&config, &layout, &results, &snapshot, firstSeed, r, skipIdle, warmupTicks]
+        {
+            SimulationRun run(config, layout, firstSeed + r);
+            if (warmupTicks > 0)
+                run.branch(snapshot);
+            else if (skipIdle)
+                run.enableIdleSkipping();
+            run.runToEnd();
+            results[r] = run.getResult();
+        });
+    }
+    pool.wait();
+    return results;
+}
+
+// one row of the summary table
+static void printStatistic(ostream& out, const string& name, const vector<double>& values)
+{
+    SummaryStatistic statistic = summarize(values);
+    out << left << setw(22) << name << right << fixed << setprecision(2)
+        << setw(12) << statistic.mean << " +/- " << setw(9) << statistic.halfWidth
+        << "   (sd " << statistic.standardDeviation << ")" << endl;
+}
+
+void printReplicationReport(const vector<RunResult>& results, ostream& out)
+{
+    for (int r = 0; r < static_cast<int>(results.size()); r++)
+    {
+        const RunResult& result = results[r];
+        out << "replication " << r << " seed " << result.seed
+            << ": generated " << result.vehiclesGenerated
+            << ", exited N " << result.exits[static_cast<int>(Direction::north)]
+            << " S " << result.exits[static_cast<int>(Direction::south)]
+            << " E " << result.exits[static_cast<int>(Direction::east)]
+            << " W " << result.exits[static_cast<int>(Direction::west)]
+            << ", rows in use " << result.rowsInUse
+            << ", mean travel " << result.meanTravelTicks << ", mean delay " << result.meanDelayTicks << endl;
+    }
+
+    vector<double> generated, exited[4], throughput, travel, delay;
+    for (const RunResult& result : results)
+    {
+        generated.push_back(result.vehiclesGenerated);
+        int totalExited = 0;
+        for (int d = 0; d < 4; d++)
+        {
+            exited[d].push_back(result.exits[d]);
+            totalExited += result.exits[d];
+        }
+        throughput.push_back(result.ticks > 0 ? static_cast<double>(totalExited) / result.ticks : 0);
+        travel.push_back(result.meanTravelTicks);
+        delay.push_back(result.meanDelayTicks);
+    }
+
+    out << endl << results.size() << " replications, mean +/- 95% confidence interval half-width:" << endl;
+    printStatistic(out, "vehicles generated", generated);
+    printStatistic(out, "exited northbound", exited[static_cast<int>(Direction::north)]);
+    printStatistic(out, "exited southbound", exited[static_cast<int>(Direction::south)]);
+    printStatistic(out, "exited eastbound", exited[static_cast<int>(Direction::east)]);
+    printStatistic(out, "exited westbound", exited[static_cast<int>(Direction::west)]);
+    printStatistic(out, "exits per tick", throughput);
+    printStatistic(out, "mean travel ticks", travel);
+    printStatistic(out, "mean delay ticks", delay);
+    out.unsetf(ios::fixed);
+}
+
+#endif
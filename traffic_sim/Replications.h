@@ -0,0 +1,40 @@
+#ifndef __REPLICATIONS_H__
+#define __REPLICATIONS_H__
+
+#include <ostream>
+#include <vector>
+#include "Config.h"
+#include "Network.h"
+#include "SimulationRun.h"
+#include "ThreadPool.h"
+
+// mean of a set of replication values with a 95% confidence interval
+// (mean +/- halfWidth, using Student's t for small samples)
+struct SummaryStatistic
+{
+    double mean;
+    double standardDeviation;
+    double halfWidth;
+};
+
+SummaryStatistic summarize(const std::vector<double>& values);
+
+// Run independent headless replications seeded firstSeed, firstSeed + 1,
+// ... on the pool. Replication r gives exactly the result of a single run
+// with seed firstSeed + r; results come back in replication order no
+// matter which thread ran them. With skipIdle each run uses next-event
+// mode (SimulationRun::enableIdleSkipping) and that no longer holds.
+//
+// With warmupTicks, a single run with firstSeed is simulated up to that
+// tick first and every replication branches from a snapshot of it instead
+// of starting from empty lanes (see SimulationRun::branch): replication r
+// carries on with the streams of seed firstSeed + r, and its results only
+// cover the ticks after the warm-up. Replication 0 is then exactly the
+// tail of a single run with firstSeed.
+std::vector<RunResult> runReplications(const SimulationConfig& config, const NetworkLayout& layout,
+    unsigned int firstSeed, int replications, ThreadPool& pool, bool skipIdle = false, int warmupTicks = 0);
+
+// one line per replication followed by mean and 95% CI of each measure
+void printReplicationReport(const std::vector<RunResult>& results, std::ostream& out);
+
+#endif
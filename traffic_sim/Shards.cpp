@@ -0,0 +1,338 @@
+#ifndef __SHARDS_CPP__
+#define __SHARDS_CPP__
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Checkpoint.h"
+#include "Shards.h"
+
+using namespace::std;
+
+// control messages on the worker sockets: u32 length, then a payload
+// starting with one of these
+static const uint8_t READY = 1;  // worker -> coordinator: region built
+static const uint8_t START = 2;  // coordinator -> worker: run every tick
+static const uint8_t RESULT = 3; // worker -> coordinator: the region's statistics follow
+
+// one section in a shared-memory mailbox
+struct MailboxEntry
+{
+    int64_t vehicleID;
+    int32_t column;
+    int32_t type;
+};
+
+// The shared memory: the barrier, then for every shard, tick parity and
+// edge (north, south) a mailbox holding a count, capacity entries and the
+// entry queue lengths of the edge's capacity columns.
+class SharedMailboxes
+{
+   private:
+      uint8_t* memory;
+      size_t bytes;
+      int shards;
+      int capacity;
+      size_t headerBytes;
+      size_t mailboxBytes;
+
+   public:
+      SharedMailboxes(int shards, int capacity) : shards(shards), capacity(capacity)
+      {
+         headerBytes = (sizeof(pthread_barrier_t) + 63) / 64 * 64;
+         mailboxBytes = (sizeof(int64_t) + capacity * (sizeof(MailboxEntry) + sizeof(int32_t)) + 63) / 64 * 64;
+         bytes = headerBytes + shards * 4 * mailboxBytes;
+         void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+         if (mapped == MAP_FAILED)
+         {
+            cerr << "Could not map shared memory for " << shards << " shards" << endl;
+            exit(0);
+         }
+         memory = static_cast<uint8_t*>(mapped);
+
+         pthread_barrierattr_t attributes;
+         pthread_barrierattr_init(&attributes);
+         pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+         pthread_barrier_init(getBarrier(), &attributes, shards);
+         pthread_barrierattr_destroy(&attributes);
+      }
+
+      ~SharedMailboxes()
+      {
+         pthread_barrier_destroy(getBarrier());
+         munmap(memory, bytes);
+      }
+
+      inline pthread_barrier_t* getBarrier() { return reinterpret_cast<pthread_barrier_t*>(memory); }
+      inline int getCapacity() const { return capacity; }
+      inline int32_t& count(int shard, int parity, int edge)
+            { return *reinterpret_cast<int32_t*>(mailbox(shard, parity, edge)); }
+      inline MailboxEntry* entries(int shard, int parity, int edge)
+            { return reinterpret_cast<MailboxEntry*>(mailbox(shard, parity, edge) + sizeof(int64_t)); }
+      inline int32_t* queued(int shard, int parity, int edge)
+            { return reinterpret_cast<int32_t*>(entries(shard, parity, edge) + capacity); }
+
+   private:
+      inline uint8_t* mailbox(int shard, int parity, int edge)
+            { return memory + headerBytes + ((shard * 2 + parity) * 2 + edge) * mailboxBytes; }
+};
+
+static bool writeAll(int fd, const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static bool readAll(int fd, uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t got = read(fd, data, size);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return false;
+        data += got;
+        size -= got;
+    }
+    return true;
+}
+
+static bool sendMessage(int fd, const CheckpointWriter& message)
+{
+    const vector<uint8_t>& payload = message.getPayload();
+    uint8_t length[4];
+    for (int i = 0; i < 4; i++)
+        length[i] = static_cast<uint8_t>(payload.size() >> (8 * i));
+    return writeAll(fd, length, 4) && writeAll(fd, payload.data(), payload.size());
+}
+
+static bool receiveMessage(int fd, vector<uint8_t>& payload)
+{
+    uint8_t length[4];
+    if (!readAll(fd, length, 4))
+        return false;
+    payload.resize(length[0] | length[1] << 8 | length[2] << 16 | static_cast<uint32_t>(length[3]) << 24);
+    return readAll(fd, payload.data(), payload.size());
+}
+
+static void writeMailbox(SharedMailboxes& shared, int shard, int parity, int edge, const vector<BoundarySection>& sections,
+                         const vector<int>& queued)
+{
+    if (static_cast<int>(sections.size()) > shared.getCapacity())
+    {
+        cerr << "Shard " << shard << ": " << sections.size() << " sections crossed an edge of "
+             << shared.getCapacity() << " lanes in one tick" << endl;
+        _exit(1);
+    }
+    MailboxEntry* entries = shared.entries(shard, parity, edge);
+    for (size_t i = 0; i < sections.size(); i++)
+        entries[i] = {sections[i].section.vehicleID, sections[i].column, static_cast<int32_t>(sections[i].section.type)};
+    shared.count(shard, parity, edge) = sections.size();
+    copy(queued.begin(), queued.end(), shared.queued(shard, parity, edge));
+}
+
+static void readMailbox(SharedMailboxes& shared, int shard, int parity, int edge, vector<BoundarySection>& sections,
+                        vector<int>& queued)
+{
+    int count = shared.count(shard, parity, edge);
+    const MailboxEntry* entries = shared.entries(shard, parity, edge);
+    sections.resize(count);
+    for (int i = 0; i < count; i++)
+        sections[i] = {entries[i].column, {entries[i].vehicleID, static_cast<VehicleType>(entries[i].type)}};
+    const int32_t* lengths = shared.queued(shard, parity, edge);
+    queued.assign(lengths, lengths + shared.getCapacity());
+}
+
+// the body of worker process shard: simulate rows firstRow to lastRow in lock step with the others
+static void runWorker(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed,
+                      int shard, int shards, int firstRow, int lastRow, SharedMailboxes& shared, int control)
+{
+    Network region(config, layout, seed, firstRow, lastRow);
+
+    CheckpointWriter ready;
+    ready.put8(READY);
+    vector<uint8_t> message;
+    if (!sendMessage(control, ready) || !receiveMessage(control, message) || message.empty() || message[0] != START)
+        _exit(1);
+
+    vector<BoundarySection> incoming;
+    vector<int> queued;
+    for (int tick = 0; tick < config.maximum_simulated_time; tick++)
+    {
+        region.step(tick);
+
+        // edge 0 is what left through the north edge, 1 the south edge
+        int parity = tick & 1;
+        writeMailbox(shared, shard, parity, 0, region.getBoundaryOutbox(Direction::north), region.getBoundaryQueues(Direction::north));
+        writeMailbox(shared, shard, parity, 1, region.getBoundaryOutbox(Direction::south), region.getBoundaryQueues(Direction::south));
+        pthread_barrier_wait(shared.getBarrier());
+
+        if (shard < shards - 1)
+        {
+            readMailbox(shared, shard + 1, parity, 0, incoming, queued);
+            region.receiveBoundary(Direction::north, incoming, queued);
+        }
+        if (shard > 0)
+        {
+            readMailbox(shared, shard - 1, parity, 1, incoming, queued);
+            region.receiveBoundary(Direction::south, incoming, queued);
+        }
+    }
+
+    CheckpointWriter result;
+    result.put8(RESULT);
+    for (int d = 0; d < 4; d++)
+        result.put32(region.getExitCount(static_cast<Direction>(d)));
+    result.put32(region.getVehicleCount());
+    result.put32(region.getRowsInUse());
+    result.put32(region.getHighWaterMarks());
+    result.put64(region.getCompletedVehicles());
+    result.put64(region.getTotalTravelTicks());
+    result.put64(region.getTotalDelayTicks());
+    region.getCounters().save(result);
+    region.getTripTimes().save(result);
+    _exit(sendMessage(control, result) ? 0 : 1);
+}
+
+// a worker failed: stop the others (they would wait at the barrier forever) and give up
+static void abandon(const vector<pid_t>& workers, int shard)
+{
+    for (pid_t worker : workers)
+        kill(worker, SIGKILL);
+    for (pid_t worker : workers)
+        waitpid(worker, nullptr, 0);
+    cerr << "Shard " << shard << " stopped before finishing its region" << endl;
+    exit(0);
+}
+
+ShardedResult runSharded(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed, int shards)
+{
+    shards = max(1, min(shards, layout.rows));
+    // a lane hands at most one section to the next intersection per tick
+    SharedMailboxes shared(shards, layout.columns);
+
+    cout.flush(); // don't let the workers inherit buffered output
+    vector<pid_t> workers;
+    vector<int> controls;
+    for (int s = 0; s < shards; s++)
+    {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+        {
+            cerr << "Could not create the control socket for shard " << s << endl;
+            exit(0);
+        }
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            cerr << "Could not start shard " << s << endl;
+            abandon(workers, s);
+        }
+        if (pid == 0)
+        {
+            close(sockets[0]);
+            for (int control : controls)
+                close(control);
+            runWorker(config, layout, seed, s, shards, layout.rows * s / shards, layout.rows * (s + 1) / shards - 1,
+                      shared, sockets[1]);
+        }
+        close(sockets[1]);
+        workers.push_back(pid);
+        controls.push_back(sockets[0]);
+    }
+
+    vector<uint8_t> message;
+    for (int s = 0; s < shards; s++)
+        if (!receiveMessage(controls[s], message) || message.empty() || message[0] != READY)
+            abandon(workers, s);
+
+    auto startTime = chrono::steady_clock::now();
+    CheckpointWriter start;
+    start.put8(START);
+    for (int s = 0; s < shards; s++)
+        if (!sendMessage(controls[s], start))
+            abandon(workers, s);
+
+    // results arrive in any order; a closed socket means that worker died
+    ShardedResult sharded;
+    RunResult& result = sharded.run;
+    result.seed = seed;
+    result.ticks = config.maximum_simulated_time;
+    result.vehiclesGenerated = 0;
+    for (int d = 0; d < 4; d++)
+        result.exits[d] = 0;
+    result.rowsInUse = 0;
+    result.highWaterMarks = 0;
+    long long completed = 0, travel = 0, delay = 0;
+    vector<bool> finished(shards, false);
+    for (int remaining = shards; remaining > 0; )
+    {
+        vector<pollfd> waiting;
+        for (int s = 0; s < shards; s++)
+            if (!finished[s])
+                waiting.push_back({controls[s], POLLIN, 0});
+        if (poll(waiting.data(), waiting.size(), -1) < 0 && errno != EINTR)
+            abandon(workers, 0);
+        for (int s = 0; s < shards; s++)
+        {
+            if (finished[s])
+                continue;
+            auto ready = find_if(waiting.begin(), waiting.end(), [&](const pollfd& p) { return p.fd == controls[s]; });
+            if (ready->revents == 0)
+                continue;
+            if (!receiveMessage(controls[s], message) || message.empty() || message[0] != RESULT)
+                abandon(workers, s);
+
+            CheckpointReader in(message, "shard result");
+            in.get8();
+            for (int d = 0; d < 4; d++)
+                result.exits[d] += in.get32();
+            result.vehiclesGenerated += in.get32();
+            result.rowsInUse += in.get32();
+            result.highWaterMarks += in.get32();
+            completed += in.get64();
+            travel += in.get64();
+            delay += in.get64();
+            TrafficCounters counters;
+            counters.restore(in);
+            sharded.counters.add(counters);
+            TripTimes tripTimes;
+            tripTimes.restore(in);
+            sharded.tripTimes.merge(tripTimes);
+            finished[s] = true;
+            remaining--;
+        }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - startTime;
+
+    for (int s = 0; s < shards; s++)
+    {
+        close(controls[s]);
+        waitpid(workers[s], nullptr, 0);
+    }
+    result.meanTravelTicks = completed > 0 ? static_cast<double>(travel) / completed : 0;
+    result.meanDelayTicks = completed > 0 ? static_cast<double>(delay) / completed : 0;
+    result.seconds = elapsed.count();
+    return sharded;
+}
+
+#endif
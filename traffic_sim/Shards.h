@@ -0,0 +1,38 @@
+#ifndef __SHARDS_H__
+#define __SHARDS_H__
+
+#include "Config.h"
+#include "Metrics.h"
+#include "Network.h"
+#include "SimulationRun.h"
+
+// what a sharded run reports, as the whole network would
+struct ShardedResult
+{
+    RunResult       run;
+    TrafficCounters counters;
+    TripTimes       tripTimes;
+};
+
+// Sharded run: the network's rows are split into shards bands (regions),
+// each simulated by a worker process that only builds its own region
+// (see Network's region constructor). The processes are forked from this
+// one and run every tick in lock step:
+//    - each steps its region and writes the sections that left through
+//      its north and south edges, and the entry queue lengths of its edge
+//      approaches, to its shared-memory mailboxes
+//    - all wait at a process-shared barrier
+//    - each reads its neighbours' mailboxes into its edge approaches, and
+//      from their queue lengths which of its edge lanes have to hold their
+//      last section next tick (see Network::receiveBoundary)
+// The mailboxes alternate between two sets by tick, so a worker can fill
+// next tick's while its neighbours are still reading this tick's, and one
+// barrier per tick is enough. The coordinator (this process) talks to each
+// worker over a Unix-domain socket: it waits for every worker to report
+// ready, tells them all to start, and collects their statistics when they
+// finish, killing the rest if a worker dies. Every intersection keeps the
+// seed, vehicle IDs and random numbers it has in a single process, so the
+// results are exactly those of a single-process run with the same seed.
+ShardedResult runSharded(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed, int shards);
+
+#endif
@@ -5,488 +5,423 @@
 
 #include <iostream>
 #include <vector>
-#include <random>
 #include <map>
-#include <fstream>
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
 #include <algorithm>
-#include <cctype>
+#include <memory>
+#include <functional>
+#include <fstream>
 #include "VehicleBase.h"
 #include "Animator.h"
+#include "Config.h"
+#include "Network.h"
+#include "SimulationRun.h"
+#include "Replications.h"
+#include "ThreadPool.h"
+#include "Sweep.h"
+#include "Trace.h"
+#include "Playback.h"
+#include "Metrics.h"
+#include "StatsWriter.h"
+#include "RenderThread.h"
+#include "Shards.h"
 
 using namespace::std;
 
 // method prototypes:
-vector<VehicleType> generate();
-void loadVehicles(vector<VehicleType> newVehicles, vector<VehicleBase*>& v, Direction d);
 void readInput(int argc, char* argv[]);
-void movePassed(vector<VehicleBase*> &v, int num_sec);
-void movePre(vector<VehicleBase*> &v, int num_sec);
-void moveThrough(vector<VehicleBase*> &v, vector<VehicleBase*> &r, vector<VehicleBase*> &l, vector<VehicleBase*> &o, int num_sec, int currentTimeLeft);
+void printSummary(const RunResult& result, const TrafficCounters& counters, const TripTimes& tripTimes);
+void replay(const string& fileName, int fromTick);
+void drawIntersection(Animator& animator, Intersection& shown, int tick);
+void writeMetrics(const MetricsSeries* series);
 
 // instance variables of the class:
 // from input file
-int maximum_simulated_time;
-int number_of_sections_before_intersection;
-int green_north_south;
-int yellow_north_south;
-int green_east_west;
-int yellow_east_west;
-double prob_new_vehicle_northbound;
-double prob_new_vehicle_southbound;
-double prob_new_vehicle_eastbound;
-double prob_new_vehicle_westbound;
-double proportion_of_cars;
-double proportion_of_SUVs;
-double proportion_right_turn_cars;
-double proportion_left_turn_cars;
-double proportion_right_turn_SUVs;
-double proportion_left_turn_SUVs;
-double proportion_right_turn_trucks;
-double proportion_left_turn_trucks;
-// created by us
-int currentNS;
-int currentEW;
-bool goEW;
-int genAmts[4];
+map<string, double> input_dict;
+SimulationConfig config;
+// from the command line
+unsigned int initialSeed;
+NetworkLayout layout;
+string networkFile;
+// run mode (from optional command line flags)
+bool headless = false; // --headless: no Animator output and no waiting on cin between ticks
+bool skipIdle = false; // --skip-idle: headless runs, replications and sweeps jump over ticks with nothing on the road
+int viewRow = 0;       // --view r,c: the intersection of a network the Animator draws
+int viewColumn = 0;
+int replications = 0;  // --replications N: run N headless replications with seeds seed, seed + 1, ...
+int warmupTicks = 0;   // --warmup W: replications (and each sweep point) branch from one run warmed up for W ticks
+int shards = 0;        // --shards S: headless run split into S worker processes, each simulating a band of rows
+int stepThreads = 1;   // --step-threads T: threads stepping the intersections of a single run (0 = one per core)
+int threads = 0;       // --threads T: worker threads for replications and sweeps (0 = one per core)
+string sweepFile;      // --sweep spec: run every combination of the values in the spec and print CSV
+string recordFile;     // --record file: write a trace of the viewed intersection, one frame per tick
+int keyframeInterval = 256; // --keyframe-every K: a full frame every K ticks in the trace, deltas between
+string replayFile;     // --replay file: draw a recorded trace instead of simulating
+int replayFrom = 0;    // --from T: first tick to draw when replaying
+double fps = 0;        // --fps F: play back at F frames per second instead of waiting for Enter
+int renderEvery = 1;   // --render-every N: simulate N ticks per drawn frame
+string metricsFile;    // --metrics file: write the per-lane counters as a CSV time series
+int metricsInterval = 1; // --metrics-every K: one row of the time series every K ticks
+string statsFile;      // --stats file: per-tick lights, queues, arrivals and departures of every intersection
+StatsFormat statsFormat = StatsFormat::csv; // --stats-format csv|binary: how that file is written
+int checkpointInterval = 0; // --checkpoint-every N: headless runs save their state every N ticks
+string checkpointFile = "simulation.checkpoint"; // --checkpoint-file file: where those checkpoints go
+string resumeFile;     // --resume file: carry on from a checkpoint instead of starting at tick 0
 char moveOn;
 
-std::mt19937 rng; // creates instance of mt19937 for random number generation
-std::uniform_real_distribution<double> rand_double(0.0, 1.0);
-
 int main(int argc, char* argv[])
 {
-    int initialSeed = atoi(argv[2]); // sets initial seed to the third command line argument
-    rng.seed(initialSeed); // sets seed - call rand_double(rng) every time you want to get a new random.
-    readInput(argc, argv); // read in the input file & assign instance variables their proper values (per the input file)
-    
-    Animator animator(number_of_sections_before_intersection); // construct an Animator
-    
-    // set the initial light colors
-    animator.setLightNorthSouth(LightColor::red);
-    currentNS = 0; // time left until NS is red
-    animator.setLightEastWest(LightColor::green);
-    currentEW = green_east_west + yellow_east_west; // time left until EW is red 
-    // no distinction for the vehicles between green and yellow
-
-    // initialize vectors of type VehicleBase* for all sections
-    vector<VehicleBase*> westbound(number_of_sections_before_intersection * 2 + 2, nullptr);
-    vector<VehicleBase*> eastbound(number_of_sections_before_intersection * 2 + 2, nullptr);
-    vector<VehicleBase*> southbound(number_of_sections_before_intersection * 2 + 2, nullptr);
-    vector<VehicleBase*> northbound(number_of_sections_before_intersection * 2 + 2, nullptr);
-    
-    goEW = true; // EW light is initially green so goEW is initialized to true
-
-    for(int i = 0; i < maximum_simulated_time; i++)
-    {
-        // move passed vehicles, including those in the second phase of the intersection (past the point of no return)
-        movePassed(northbound, number_of_sections_before_intersection);
-        movePassed(southbound, number_of_sections_before_intersection);
-        movePassed(eastbound, number_of_sections_before_intersection);
-        movePassed(westbound, number_of_sections_before_intersection);
-
-        // move through intersection and turn if appropriate - only go if there's enough time to make it through
-        // pass all 4 vehicle vectors to method in order to handle left turns
-        if (goEW == true)
-        {
-            moveThrough(eastbound, southbound, northbound, westbound, number_of_sections_before_intersection, currentEW);
-            moveThrough(westbound, northbound, southbound, eastbound, number_of_sections_before_intersection, currentEW);
-        }
-        else
-        {
-            moveThrough(northbound, eastbound, westbound, southbound, number_of_sections_before_intersection, currentNS);
-            moveThrough(southbound, westbound, eastbound, northbound, number_of_sections_before_intersection, currentNS);
-        }
-        
-        // move pre-intersection vehicles
-        movePre(northbound, number_of_sections_before_intersection);
-        movePre(southbound, number_of_sections_before_intersection);
-        movePre(eastbound, number_of_sections_before_intersection);
-        movePre(westbound, number_of_sections_before_intersection);
-        
-        // decrease currentEW or NS by 1 until it equals 0 and then change lights/direction of traffic flow
-        // change green to yellow during that process depending on length of yellow light
-        if (goEW == true) // EW is green or yellow
-        {
-            if (currentEW == 0) // lights are about to change
-            {
-                animator.setLightEastWest(LightColor::red);
-                goEW = 0; // time for north and south to move
-                animator.setLightNorthSouth(LightColor::green);
-                currentNS = green_north_south + yellow_north_south; // time left until NS is red
-            }
-            else if (currentEW == yellow_east_west)
-            {
-                animator.setLightEastWest(LightColor::yellow);
-                currentEW--;
-            }
-            else
-                currentEW--;
-        }
-        else // NS is green or yellow
-        {
-            if (currentNS == 0) // lights are about to change
-            {
-                animator.setLightNorthSouth(LightColor::red);
-                animator.setLightEastWest(LightColor::green);
-                goEW = 1; // time for east and west to move
-                currentEW = green_east_west + yellow_east_west; // time left until EW is red
-            }
-            else if (currentNS == yellow_north_south)
-            {
-                animator.setLightNorthSouth(LightColor::yellow);
-                currentNS--;
-            }
-            else
-                currentNS--;
-        }
-
-        // randomly generates which vehicles are to be created (if there is space for them, which is checked in loadVehicles)
-        vector<VehicleType> newVehicles = generate(); 
+    readInput(argc, argv); // read in the input file & command line options
 
-        // checks if there is space for a vehicle in that direction and if appropriate generates a vehicle with type and turn
-        // allows for continuous generation for the following parts of a vehicle
-        loadVehicles(newVehicles, northbound, Direction::north); 
-        loadVehicles(newVehicles, southbound, Direction::south);
-        loadVehicles(newVehicles, eastbound, Direction::east);  
-        loadVehicles(newVehicles, westbound, Direction::west);
+    if (!replayFile.empty())
+    {
+        replay(replayFile, replayFrom);
+        return 0;
+    }
 
-        // place vehicles in animator and draw the intersection
-        animator.setVehiclesNorthbound(northbound);
-        animator.setVehiclesWestbound(westbound);
-        animator.setVehiclesSouthbound(southbound);
-        animator.setVehiclesEastbound(eastbound);
-        animator.draw(i);
+    if (!sweepFile.empty())
+    {
+        vector<SweepDimension> dimensions = readSweepSpec(sweepFile, input_dict);
+        ThreadPool pool(threads);
+        runSweep(input_dict, dimensions, networkFile, initialSeed, max(replications, 1), pool, cout, skipIdle, warmupTicks);
+        return 0;
+    }
 
-        // move to next tick with each input click
-        cin.get(moveOn);
-    }    
-}
+    if (replications > 0)
+    {
+        ThreadPool pool(threads);
+        vector<RunResult> results = runReplications(config, layout, initialSeed, replications, pool, skipIdle, warmupTicks);
+        printReplicationReport(results, cout);
+        return 0;
+    }
 
-vector<VehicleType> generate()
-{
-    vector<VehicleType> generatedVehicles;
+    if (shards > 0)
+    {
+        ShardedResult sharded = runSharded(config, layout, initialSeed, shards);
+        printSummary(sharded.run, sharded.counters, sharded.tripTimes);
+        return 0;
+    }
 
-    // north section:
-    if(rand_double(rng) < prob_new_vehicle_northbound) // checks if a car should be generated
+    // one intersection unless --network gives a grid
+    SimulationRun run(config, layout, initialSeed);
+    Network& network = run.getNetwork();
+    unique_ptr<ThreadPool> stepPool;
+    if (stepThreads != 1)
     {
-        double nRand = rand_double(rng); // generates a new random number to be used for north vehicle type calculations
-         if (nRand < proportion_of_cars) // checks if a car should be created
-            generatedVehicles.push_back(VehicleType::car); // push it to a vector that will be returned back to the main method
-        else if (nRand < proportion_of_SUVs + proportion_of_cars) // checks if a suv should be created
-            generatedVehicles.push_back(VehicleType::suv);
-        else // if not car or suv, create a truck
-            generatedVehicles.push_back(VehicleType::truck);
+        stepPool.reset(new ThreadPool(stepThreads));
+        network.setThreadPool(stepPool.get());
     }
-    else // if no car should be generated, push a 'none' vehicle type (added to the enum class) to maintain proper ordering in the vector
-        generatedVehicles.push_back(VehicleType::none);
-    
-    // south section:
-    if(rand_double(rng) < prob_new_vehicle_southbound)
+    if (!resumeFile.empty())
+        run.resume(resumeFile);
+
+    Intersection& shown = network.at(viewRow, viewColumn);
+    unique_ptr<TraceWriter> recorder;
+    if (!recordFile.empty())
+        recorder.reset(new TraceWriter(recordFile, config.number_of_sections_before_intersection, keyframeInterval));
+    function<void(int)> record = nullptr;
+    if (recorder)
+        record = [&recorder, &shown](int tick) { recorder->record(tick, shown); };
+    unique_ptr<MetricsSeries> series;
+    if (!metricsFile.empty())
     {
-        double sRand = rand_double(rng);
-         if (sRand < proportion_of_cars)
-            generatedVehicles.push_back(VehicleType::car);
-        else if (sRand < proportion_of_SUVs + proportion_of_cars)
-            generatedVehicles.push_back(VehicleType::suv);
-        else
-            generatedVehicles.push_back(VehicleType::truck);
+        series.reset(new MetricsSeries(metricsInterval));
+        series->start(network.getCounters()); // only count the ticks after a resume
+        function<void(int)> recordTrace = record;
+        record = [recordTrace, &series, &network](int tick)
+        {
+            if (recordTrace)
+                recordTrace(tick);
+            if (series->wantsSample(tick))
+                series->afterTick(tick, network.getCounters());
+        };
     }
-    else
-        generatedVehicles.push_back(VehicleType::none);
-    
-    // east section:
-    if(rand_double(rng) < prob_new_vehicle_eastbound)
+
+    unique_ptr<StatsWriter> stats;
+    if (!statsFile.empty())
     {
-        double eRand = rand_double(rng);
-         if (eRand < proportion_of_cars)
-            generatedVehicles.push_back(VehicleType::car);
-        else if (eRand < proportion_of_SUVs + proportion_of_cars)
-            generatedVehicles.push_back(VehicleType::suv);
-        else
-            generatedVehicles.push_back(VehicleType::truck);
+        stats.reset(new StatsWriter(statsFile, statsFormat));
+        stats->start(network); // only count the ticks after a resume
+        function<void(int)> recordBefore = record;
+        record = [recordBefore, &stats, &network](int tick)
+        {
+            if (recordBefore)
+                recordBefore(tick);
+            stats->record(tick, network);
+        };
     }
-    else
-        generatedVehicles.push_back(VehicleType::none);
 
-    // west section:
-    if(rand_double(rng) < prob_new_vehicle_westbound)
+    if (headless)
     {
-        double wRand = rand_double(rng);
-         if (wRand < proportion_of_cars)
-            generatedVehicles.push_back(VehicleType::car);
-        else if (wRand < proportion_of_SUVs + proportion_of_cars)
-            generatedVehicles.push_back(VehicleType::suv);
-        else
-            generatedVehicles.push_back(VehicleType::truck);
+        if (skipIdle)
+            run.enableIdleSkipping();
+        run.setCheckpoints(checkpointFile, checkpointInterval);
+        run.runToEnd(record);
+        if (stats)
+            stats->close();
+        printSummary(run.getResult(), network.getCounters(), network.getTripTimes());
+        writeMetrics(series.get());
+        return 0;
     }
-    else
-        generatedVehicles.push_back(VehicleType::none);
-    
-    return generatedVehicles; // return vector to main method
-}
 
+    if (fps > 0)
+    {
+        // paced playback: a steady frame rate with keyboard controls; frames are drawn on a
+        // thread of their own so the terminal can't slow the simulation down
+        RenderThread renderer(config.number_of_sections_before_intersection);
+        Playback playback(run, [&renderer, &shown](int tick) { renderer.publish(tick, shown); },
+                          record, PlaybackOptions{fps, renderEvery});
+        playback.play();
+        renderer.finish();
+        writeMetrics(series.get());
+        return 0;
+    }
 
-void loadVehicles(vector<VehicleType> newVehicles, vector<VehicleBase*> &v, Direction d)
-{
-    int dirInt = static_cast<underlying_type<Direction>::type>(d); // looks at direction to know which number in newVehicles to check?
-    // @Brett please add clear docs for what dirInt and genAmts are (ik its related to not generating new vehicles if one is already there but be specific)
+    Animator animator(config.number_of_sections_before_intersection); // construct an Animator
 
-    if(v[0] == nullptr)
+    while (!run.finished())
     {
-        if(genAmts[dirInt] != 0)
-        {
-            v[0] = v[1];
-            genAmts[dirInt]--;
-        }
-        else if(newVehicles[dirInt] == VehicleType::car)
-        {
-            double turnRand = rand_double(rng);  // generates a random number to determine if vehicle will turn
-            // create new vehicle of specified type (car in this case) and turn (depends on turnRand)
-            if (turnRand < proportion_right_turn_cars)
-                v[0] = new VehicleBase(VehicleType::car, d, Turn::right);
-            else if(turnRand < proportion_right_turn_cars + proportion_left_turn_cars)
-                v[0] = new VehicleBase(VehicleType::car, d, Turn::left);
-            else
-                v[0] = new VehicleBase(VehicleType::car, d, Turn::straight);
-            genAmts[dirInt] = 1; // how many sections are left in the generated car/suv/truck
-        }
-        // repeat for suvs and trucks, set genAmts to the correct number
-        else if(newVehicles[dirInt] == VehicleType::suv)
+        // move every vehicle, update the lights and generate new arrivals at each intersection
+        int i = 0;
+        for (int n = 0; n < renderEvery && !run.finished(); n++)
         {
-            double turnRand = rand_double(rng); 
-            if (turnRand < proportion_right_turn_SUVs)
-                v[0] = new VehicleBase(VehicleType::suv, d, Turn::right);
-            else if(turnRand < proportion_right_turn_SUVs + proportion_left_turn_SUVs)
-                v[0] = new VehicleBase(VehicleType::suv, d, Turn::left);
-            else
-                v[0] = new VehicleBase(VehicleType::suv, d, Turn::straight);
-            genAmts[dirInt] = 2;
+            i = run.getTick();
+            run.step();
+            if (record)
+                record(i);
         }
-        else if(newVehicles[dirInt] == VehicleType::truck)
-        {
-            double turnRand = rand_double(rng);
-            if (turnRand < proportion_right_turn_trucks)
-                v[0] = new VehicleBase(VehicleType::truck, d, Turn::right);
-            else if(turnRand < proportion_right_turn_trucks + proportion_left_turn_trucks)
-                v[0] = new VehicleBase(VehicleType::truck, d, Turn::left);
-            else
-                v[0] = new VehicleBase(VehicleType::truck, d, Turn::straight);
-            genAmts[dirInt] = 3;
-        }
-    }
 
+        // place vehicles and lights in animator and draw the intersection
+        drawIntersection(animator, shown, i);
+
+        // move to next tick with each input click
+        cin.get(moveOn);
+    }    
+    writeMetrics(series.get());
 }
 
-void movePassed(vector<VehicleBase*> &v, int num_sec)
+void writeMetrics(const MetricsSeries* series)
 {
-    int length = num_sec * 2 + 2;
-    v[length-1] = nullptr; // remove vehicle sections from the end
-
-    // move each vehicle one section forward from back to front to avoid overwriting sections
-    for(int i = length-2; i >= num_sec + 1; i--)
+    if (series == nullptr)
+        return;
+    ofstream out(metricsFile);
+    if (!out)
     {
-        v[i+1] = v[i];
-        v[i] = nullptr;
+        cerr << "Could not write metrics file " << metricsFile << endl;
+        exit(0);
     }
+    writeMetricsSeries(series->getSamples(), out);
+}
+
+void drawIntersection(Animator& animator, Intersection& shown, int tick)
+{
+    animator.setLightNorthSouth(shown.getLightNorthSouth());
+    animator.setLightEastWest(shown.getLightEastWest());
+    animator.setVehiclesNorthbound(shown.getLane(Direction::north).animatorView(shown.getVehicles()));
+    animator.setVehiclesWestbound(shown.getLane(Direction::west).animatorView(shown.getVehicles()));
+    animator.setVehiclesSouthbound(shown.getLane(Direction::south).animatorView(shown.getVehicles()));
+    animator.setVehiclesEastbound(shown.getLane(Direction::east).animatorView(shown.getVehicles()));
+    animator.draw(tick);
 }
 
-void movePre(vector<VehicleBase*> &v, int num_sec)
+void replay(const string& fileName, int fromTick)
 {
-    // move vehicle sections forward if there's no vehicle in front of it
-    // moved forward from back to front to avoid overwriting sections
-    for(int i = num_sec - 2; i >= 0; i--)
+    TraceReader reader(fileName);
+    if (reader.getFrameCount() == 0)
+        return;
+
+    Animator animator(reader.getNumSectionsBefore());
+    TraceFrame frame;
+    reader.readFrame(0, frame);
+    int firstTick = frame.tick;
+
+    // Enter moves to the next tick, typing a tick number first jumps straight to it
+    int n = fromTick - firstTick;
+    string line;
+    vector<VehicleBase*> lanes[4]; // reused, so only the first frame sizes them
+    while (n >= 0 && n < reader.getFrameCount())
     {
-        if(v[i+1] == nullptr)
-        {
-            v[i+1]=v[i];
-            v[i] = nullptr;
-        }
+        reader.readFrame(n, frame);
+
+        VehicleTable table;
+        frameLanes(frame, reader.getNumSectionsBefore(), table, lanes);
+        animator.setLightNorthSouth(frame.northSouthLight);
+        animator.setLightEastWest(frame.eastWestLight);
+        animator.setVehiclesNorthbound(lanes[static_cast<int>(Direction::north)]);
+        animator.setVehiclesWestbound(lanes[static_cast<int>(Direction::west)]);
+        animator.setVehiclesSouthbound(lanes[static_cast<int>(Direction::south)]);
+        animator.setVehiclesEastbound(lanes[static_cast<int>(Direction::east)]);
+        animator.draw(frame.tick);
+
+        if (!getline(cin, line))
+            break;
+        if (line.empty())
+            n++;
+        else
+            n = atoi(line.c_str()) - firstTick;
     }
 }
 
-void moveThrough(vector<VehicleBase*> &v, vector<VehicleBase*> &r, vector<VehicleBase*> &l, vector<VehicleBase*> &o, int num_sec, int currentTimeLeft)
+void printSummary(const RunResult& result, const TrafficCounters& counters, const TripTimes& tripTimes)
 {
-    // handle vehicles in 1st section of intersection (where they will either turn straight, right, or left)
-    if(v[num_sec] != nullptr)
+    // final report for headless runs, one value per line so it is easy to grep or diff
+    if (layout.rows * layout.columns > 1)
+        cout << "intersections:         " << layout.rows << "x" << layout.columns << endl;
+    cout << "ticks simulated:       " << result.ticks << endl;
+    cout << "vehicles generated:    " << result.vehiclesGenerated << endl;
+    cout << "exited northbound:     " << result.exits[static_cast<int>(Direction::north)] << endl;
+    cout << "exited southbound:     " << result.exits[static_cast<int>(Direction::south)] << endl;
+    cout << "exited eastbound:      " << result.exits[static_cast<int>(Direction::east)] << endl;
+    cout << "exited westbound:      " << result.exits[static_cast<int>(Direction::west)] << endl;
+    cout << "table rows in use:     " << result.rowsInUse << endl;
+    cout << "sum of table peaks:    " << result.highWaterMarks << endl;
+    cout << "mean travel ticks:     " << result.meanTravelTicks << endl;
+    cout << "mean delay ticks:      " << result.meanDelayTicks << endl;
+    cout << "wall clock seconds:    " << result.seconds << endl;
+    if (result.seconds > 0)
+        cout << "ticks per second:      " << result.ticks / result.seconds << endl;
+    printMetricsSummary(counters, cout);
+    printTripTimes(tripTimes, cout);
+}
+
+void readInput(int argc, char* argv[])
+{
+    // replaying a trace needs neither an input file nor a seed: ./Simulation --replay <file> [--from <tick>]
+    if (argc >= 3 && strcmp(argv[1], "--replay") == 0)
     {
-        // send vehicle forward if it's going straight
-        if(v[num_sec]->getVehicleTurn() == Turn::straight)
+        replayFile = argv[2];
+        if (argc == 5 && strcmp(argv[3], "--from") == 0)
+            replayFrom = atoi(argv[4]);
+        else if (argc != 3)
         {
-            v[num_sec+1]=v[num_sec];
-            v[num_sec] = nullptr;
+            cerr << "Usage: " << argv[0] << " --replay <trace file> [--from <tick>]" << endl;
+            exit(0);
         }
-        // send vehicle to the right if it's going right
-        else if (v[num_sec]->getVehicleTurn() == Turn::right)
-        {
-            r[num_sec+2]=v[num_sec];
-            v[num_sec] = nullptr;
-        } 
-        // send vehicle to the left if it's going left
-        else
-        {
-            l[num_sec+1] = v[num_sec];
-            v[num_sec] = nullptr;
-        }       
+        return;
     }
-    
-    // handle vehicles in section right before intersection
-    // determine if they can go based on how much time is left before their light turns red
-    // for left turns, also consider what happens when both directions want to turn left
-    if(v[num_sec-1] != nullptr)
+
+    // checks for the correct number of CLA's and prints a useful error message if that number is incorrect
+    if (argc < 3)
     {
-        int lengthLeft = 0; // number of sections until vehicle is fully into the intersection
-        int i = num_sec-2;
-        while(v[i]==v[num_sec-1]) // determine how much of the vehicle is left before the intersection
-        {
-            lengthLeft++;
-            i--;
-        }
-        // determine if vehicle can make it through before light turns red and move accordingly
-        // takes one less tick to get through right turn so right turn uses counter + 1 instead of + 2
-        if(v[num_sec-1]->getVehicleTurn() == Turn::straight && lengthLeft + 2 <= currentTimeLeft)
+        cerr << "Incorrect number of command line arguments. Please enter " << argv[0] 
+        << " and then your input file and then your initial seed for a total of 3 command line arguments." << endl;
+        exit(0);
+    }
+
+    // read the input file into a dictionary and assign the config values from it
+    input_dict = readKeyValueFile(argv[1]);
+    config = makeConfig(input_dict);
+    initialSeed = atoi(argv[2]); // sets initial seed to the third command line argument
+    layout = singleIntersectionLayout(config);
+
+    // any arguments after the seed are optional run mode flags
+    for (int arg = 3; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--headless") == 0)
+            headless = true;
+        else if (strcmp(argv[arg], "--skip-idle") == 0)
+            skipIdle = true;
+        else if (strcmp(argv[arg], "--rng") == 0 && arg + 1 < argc)
         {
-            v[num_sec]=v[num_sec-1];
-            v[num_sec-1] = nullptr;
+            // kept in the dictionary too, so sweeps (which build a config per combination) pick it up
+            string generator = argv[++arg];
+            if (generator != "counter" && generator != "mt19937")
+            {
+                cerr << "--rng expects counter or mt19937" << endl;
+                exit(0);
+            }
+            input_dict["counter_rng"] = generator == "counter";
+            config.counter_rng = generator == "counter";
         }
-        else if(v[num_sec-1]->getVehicleTurn() == Turn::right && lengthLeft + 1 <= currentTimeLeft)
+        else if (strcmp(argv[arg], "--network") == 0 && arg + 1 < argc)
         {
-            v[num_sec]=v[num_sec-1];
-            v[num_sec-1] = nullptr;
+            networkFile = argv[++arg];
+            layout = readNetworkLayout(networkFile, config);
         }
-        else if(v[num_sec-1]->getVehicleTurn() == Turn::left && lengthLeft + 2 <= currentTimeLeft)
+        else if (strcmp(argv[arg], "--sweep") == 0 && arg + 1 < argc)
+            sweepFile = argv[++arg];
+        else if (strcmp(argv[arg], "--record") == 0 && arg + 1 < argc)
+            recordFile = argv[++arg];
+        else if (strcmp(argv[arg], "--keyframe-every") == 0 && arg + 1 < argc)
+            keyframeInterval = max(1, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--fps") == 0 && arg + 1 < argc)
+            fps = atof(argv[++arg]);
+        else if (strcmp(argv[arg], "--render-every") == 0 && arg + 1 < argc)
+            renderEvery = max(1, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--metrics") == 0 && arg + 1 < argc)
+            metricsFile = argv[++arg];
+        else if (strcmp(argv[arg], "--metrics-every") == 0 && arg + 1 < argc)
+            metricsInterval = max(1, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--stats") == 0 && arg + 1 < argc)
+            statsFile = argv[++arg];
+        else if (strcmp(argv[arg], "--stats-format") == 0 && arg + 1 < argc)
         {
-            // find closest oncoming vehicle and determine if a collision will happen
-            bool collision = false;
-            for(int j = num_sec + 1; j > num_sec - lengthLeft - 3; j--)
+            string format = argv[++arg];
+            if (format == "csv")
+                statsFormat = StatsFormat::csv;
+            else if (format == "binary")
+                statsFormat = StatsFormat::binary;
+            else
             {
-                if(j >= 0)
-                {
-                    if(o[j] != nullptr)
-                    {
-                        int oppLengthLeft = 0;
-                        int k = j-1;
-                        while(v[k]==v[j]) // determine how much of the oncoming vehicle is left before the intersection
-                        {
-                            oppLengthLeft++;
-                            k--;
-                        }
-
-                        // determine how much time the oncoming vehicle will take to go through the intersection
-                        int oppTimeUntilThrough;
-                        if(o[j]->getVehicleTurn() == Turn::right)
-                            oppTimeUntilThrough = oppLengthLeft + 1 + (num_sec - j - 1);
-                        else
-                            oppTimeUntilThrough = oppLengthLeft + 2 + (num_sec - j - 1);
-
-                        // if oncoming vehicle turning left, give northbound and eastbound vehicles priority
-                        // if oncoming vehicle is also turning left and my vehicle is north or east, ignore it and go
-                        if(o[j]->getVehicleTurn() == Turn::left &&
-                        (v[num_sec-1]->getVehicleOriginalDirection() == Direction::north ||
-                        v[num_sec-1]->getVehicleOriginalDirection() == Direction::east))    
-                        {
-                            j = -1;
-                        }
-                        // if oncoming vehicle does not have enough time to get through light, ignore it and go
-                        else if(oppTimeUntilThrough > currentTimeLeft)           
-                        { 
-                            j = -1;
-                        }
-                        // oncoming vehicle will be going through the intersection, so stop
-                        else
-                        {
-                            collision = true;
-                            j = -1;
-                        }    
-                    }
-                } 
+                cerr << "--stats-format must be csv or binary, not " << format << endl;
+                exit(0);
             }
-            // if there won't be a collision, move forward into intersection (actual left turn handled on next tick)
-            if(!collision)
+        }
+        else if (strcmp(argv[arg], "--checkpoint-every") == 0 && arg + 1 < argc)
+            checkpointInterval = max(0, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--checkpoint-file") == 0 && arg + 1 < argc)
+            checkpointFile = argv[++arg];
+        else if (strcmp(argv[arg], "--resume") == 0 && arg + 1 < argc)
+            resumeFile = argv[++arg];
+        else if (strcmp(argv[arg], "--replications") == 0 && arg + 1 < argc)
+            replications = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "--warmup") == 0 && arg + 1 < argc)
+            warmupTicks = max(0, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--shards") == 0 && arg + 1 < argc)
+            shards = max(0, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--step-threads") == 0 && arg + 1 < argc)
+            stepThreads = max(0, atoi(argv[++arg]));
+        else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+            threads = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "--view") == 0 && arg + 1 < argc)
+        {
+            if (sscanf(argv[++arg], "%d,%d", &viewRow, &viewColumn) != 2)
             {
-                // check to make sure next space is not already occupied before moving
-                if(r[num_sec+1] == nullptr)
-                {
-                    v[num_sec]=v[num_sec-1]; 
-                    v[num_sec-1] = nullptr;
-                }
+                cerr << "--view expects row,column (e.g. --view 0,1)" << endl;
+                exit(0);
             }
-
         }
-        
+        else
+        {
+            cerr << "Unknown option: " << argv[arg] << ". Supported options: --headless, --network <file>, --view <row,column>, "
+                 << "--fps <F>, --render-every <N>, --replications <N>, --warmup <W>, --threads <T>, --step-threads <T>, --shards <S>, --sweep <spec>, --record <file>, "
+                 << "--keyframe-every <K>, --metrics <file>, --metrics-every <K>, --stats <file>, --stats-format <csv|binary>, --skip-idle, --rng <counter|mt19937>, "
+                 << "--checkpoint-every <N>, --checkpoint-file <file>, --resume <file>" << endl;
+            exit(0);
+        }
     }
-}
 
-void readInput(int argc, char* argv[])
-{
-    // checks for the correct number of CLA's and prints a useful error message if that number is incorrect
-    if (argc != 3)
+    if (shards > 0 && (fps > 0 || skipIdle || !metricsFile.empty() || !statsFile.empty() || !recordFile.empty()
+                       || checkpointInterval > 0 || !resumeFile.empty()))
     {
-        cerr << "Incorrect number of command line arguments. Please enter " << argv[0] 
-        << " and then your input file and then your initial seed for a total of 3 command line arguments." << endl;
+        cerr << "--shards runs headless, tick by tick, and only prints the summary: it can't be combined with "
+             << "--fps, --skip-idle, --metrics, --stats, --record, --checkpoint-every or --resume" << endl;
         exit(0);
     }
-    
-    // ensures the input file opens correctly
-    ifstream infile {argv[1]};
-    if (!infile)
+    if (shards > 0)
+        headless = true; // a sharded run is never drawn, so --headless is implied
+
+    if (sweepFile.empty() && warmupTicks >= config.maximum_simulated_time) // a sweep checks every point's own
     {
-        cerr << "Unable to open file: " << argv[1] << endl;
+        cerr << "--warmup " << warmupTicks << " leaves no ticks of the " << config.maximum_simulated_time << " to measure" << endl;
         exit(0);
     }
 
-    // create input dictionary to store input variables
-    map<string, double> input_dict;
-    string line;
-    string input_spec;
-    double input_value;
-
-    // read input line by line regardless of order and whitespace
-    bool colonFound = false;
-    int i = 0;
-    while (getline(infile, line))
+    if (viewRow < 0 || viewRow >= layout.rows || viewColumn < 0 || viewColumn >= layout.columns)
     {
-        // remove spaces from line, skip blank lines (length == 0)
-        line.erase(std::remove_if(line.begin(), line.end(), [](char c) { return std::isspace(c); }), line.end());
-        if (line.length() != 0)
-        {
-            while(!colonFound)
-            {
-                // iterate through the line until colon is found, then set input_spec equal to all non-ws characters before colon and 
-                // input_value equal to all non-ws characters after colon and then add key-value pair to the input dictionary
-                if (line[i] == ':')
-                {
-                    colonFound = true;
-                    input_spec = line.substr(0, i);
-                    input_value = stod(line.substr(i+1,line.length() - 1));
-                    input_dict[input_spec] = input_value;
-                }
-                i++;
-            }
-            colonFound = false;
-            i = 0;
-        }
+        cerr << "--view " << viewRow << "," << viewColumn << " is outside the " << layout.rows << "x" << layout.columns << " network" << endl;
+        exit(0);
     }
-
-    // add values from input dictionary to the instance variables created at the beginning
-    maximum_simulated_time = input_dict["maximum_simulated_time"];
-    number_of_sections_before_intersection = input_dict["number_of_sections_before_intersection"];
-    green_north_south = input_dict["green_north_south"];
-    yellow_north_south = input_dict["yellow_north_south"];
-    green_east_west = input_dict["green_east_west"];
-    yellow_east_west = input_dict["yellow_east_west"];
-    prob_new_vehicle_northbound = input_dict["prob_new_vehicle_northbound"];
-    prob_new_vehicle_southbound = input_dict["prob_new_vehicle_southbound"];
-    prob_new_vehicle_eastbound = input_dict["prob_new_vehicle_eastbound"];
-    prob_new_vehicle_westbound = input_dict["prob_new_vehicle_westbound"];
-    proportion_of_cars = input_dict["proportion_of_cars"];
-    proportion_of_SUVs = input_dict["proportion_of_SUVs"];
-    proportion_right_turn_cars = input_dict["proportion_right_turn_cars"];
-    proportion_left_turn_cars = input_dict["proportion_left_turn_cars"];
-    proportion_right_turn_SUVs = input_dict["proportion_right_turn_SUVs"];
-    proportion_left_turn_SUVs = input_dict["proportion_left_turn_SUVs"];
-    proportion_right_turn_trucks = input_dict["proportion_right_turn_trucks"];
-    proportion_left_turn_trucks = input_dict["proportion_left_turn_trucks"];
-
-    infile.close(); // close input file
-}
\ No newline at end of file
+}
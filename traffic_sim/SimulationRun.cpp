@@ -0,0 +1,184 @@
+#ifndef __SIMULATION_RUN_CPP__
+#define __SIMULATION_RUN_CPP__
+
+#include <algorithm>
+#include <chrono>
+#include "Checkpoint.h"
+#include "SimulationRun.h"
+
+using namespace::std;
+
+SimulationRun::SimulationRun(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed)
+    : config(config), seed(seed), network(config, layout, seed), tick(0), seconds(0), skipIdle(false),
+      checkpointInterval(0), nextCheckpoint(0), measuredFrom(0), vehiclesBefore(0)
+{
+
+}
+
+void SimulationRun::enableIdleSkipping()
+{
+    if (skipIdle)
+        return; // already scheduled (e.g. restored from a checkpoint)
+    skipIdle = true;
+    network.scheduleArrivals(tick);
+}
+
+void SimulationRun::setCheckpoints(const string& fileName, int interval)
+{
+    checkpointFile = fileName;
+    checkpointInterval = interval;
+    if (interval > 0)
+        nextCheckpoint = (tick / interval + 1) * interval;
+}
+
+// the config as it is stored in a checkpoint, in struct order
+static vector<double> configValues(const SimulationConfig& config)
+{
+    return {
+        static_cast<double>(config.maximum_simulated_time),
+        static_cast<double>(config.number_of_sections_before_intersection),
+        static_cast<double>(config.green_north_south),
+        static_cast<double>(config.yellow_north_south),
+        static_cast<double>(config.green_east_west),
+        static_cast<double>(config.yellow_east_west),
+        config.prob_new_vehicle_northbound,
+        config.prob_new_vehicle_southbound,
+        config.prob_new_vehicle_eastbound,
+        config.prob_new_vehicle_westbound,
+        config.proportion_of_cars,
+        config.proportion_of_SUVs,
+        config.proportion_right_turn_cars,
+        config.proportion_left_turn_cars,
+        config.proportion_right_turn_SUVs,
+        config.proportion_left_turn_SUVs,
+        config.proportion_right_turn_trucks,
+        config.proportion_left_turn_trucks,
+        static_cast<double>(config.counter_rng)
+    };
+}
+
+void SimulationRun::save(const string& fileName) const
+{
+    CheckpointWriter out;
+    save(out);
+    out.write(fileName);
+}
+
+void SimulationRun::save(CheckpointWriter& out) const
+{
+    vector<double> values = configValues(config);
+    out.put32(values.size());
+    for (double value : values)
+        out.putDouble(value);
+    out.put32(seed);
+    out.put32(tick);
+    out.putDouble(seconds);
+    out.put8(skipIdle);
+    network.save(out);
+}
+
+void SimulationRun::resume(const string& fileName)
+{
+    CheckpointReader in(fileName);
+    restore(in, true);
+}
+
+void SimulationRun::branch(const CheckpointWriter& snapshot)
+{
+    CheckpointReader in(snapshot.getPayload(), "snapshot");
+    unsigned int snapshotSeed = restore(in, false);
+    if (seed != snapshotSeed)
+        network.reseed(seed, tick);
+    network.resetStatistics();
+    measuredFrom = tick;
+    vehiclesBefore = network.getVehicleCount();
+    seconds = 0;
+}
+
+unsigned int SimulationRun::restore(CheckpointReader& in, bool sameSeed)
+{
+    vector<double> values = configValues(config);
+    if (in.get32() != values.size())
+        in.fail("written for a different input file");
+    for (double value : values)
+    {
+        if (in.getDouble() != value)
+            in.fail("written for a different input file");
+    }
+    unsigned int savedSeed = in.get32();
+    if (sameSeed && savedSeed != seed)
+        in.fail("written for seed " + to_string(savedSeed) + ", not " + to_string(seed));
+    tick = in.get32();
+    seconds = in.getDouble();
+    skipIdle = in.get8() != 0;
+    network.restore(in);
+    if (checkpointInterval > 0)
+        nextCheckpoint = (tick / checkpointInterval + 1) * checkpointInterval;
+    return savedSeed;
+}
+
+void SimulationRun::checkpointIfDue(chrono::steady_clock::time_point startTime)
+{
+    if (checkpointInterval == 0 || tick < nextCheckpoint || finished())
+        return;
+    // count the time spent so far in this runToEnd as well
+    double before = seconds;
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - startTime;
+    seconds += elapsed.count();
+    save(checkpointFile);
+    seconds = before;
+    nextCheckpoint += checkpointInterval;
+}
+
+void SimulationRun::runToEnd(const function<void(int)>& afterTick)
+{
+    runUntil(config.maximum_simulated_time, afterTick);
+}
+
+void SimulationRun::runUntil(int endTick, const function<void(int)>& afterTick)
+{
+    endTick = min(endTick, config.maximum_simulated_time);
+    auto startTime = chrono::steady_clock::now();
+    while (tick < endTick)
+    {
+        if (skipIdle && !afterTick && network.isIdle())
+        {
+            // nothing moves until the next arrival; only the lights change on the way
+            int next = min(network.getNextArrival(), endTick);
+            if (checkpointInterval > 0)
+                next = min(next, nextCheckpoint); // land on the checkpoint tick
+            if (next > tick)
+            {
+                network.skipIdleTicks(next - tick);
+                tick = next;
+                checkpointIfDue(startTime);
+                continue;
+            }
+        }
+        step();
+        if (afterTick)
+            afterTick(tick - 1);
+        checkpointIfDue(startTime);
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - startTime;
+    seconds += elapsed.count();
+}
+
+RunResult SimulationRun::getResult() const
+{
+    RunResult result;
+    result.seed = seed;
+    result.ticks = tick - measuredFrom;
+    result.vehiclesGenerated = network.getVehicleCount() - vehiclesBefore;
+    for (int d = 0; d < 4; d++)
+        result.exits[d] = network.getExitCount(static_cast<Direction>(d));
+    result.rowsInUse = network.getRowsInUse();
+    result.highWaterMarks = network.getHighWaterMarks();
+    long long completed = network.getCompletedVehicles();
+    result.meanTravelTicks = completed > 0 ? static_cast<double>(network.getTotalTravelTicks()) / completed : 0;
+    result.meanDelayTicks = completed > 0 ? static_cast<double>(network.getTotalDelayTicks()) / completed : 0;
+    result.seconds = seconds;
+    return result;
+}
+
+#endif
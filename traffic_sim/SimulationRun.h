@@ -0,0 +1,94 @@
+#ifndef __SIMULATION_RUN_H__
+#define __SIMULATION_RUN_H__
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include "Config.h"
+#include "Network.h"
+
+// what a finished (or paused) run reports
+struct RunResult
+{
+    unsigned int seed;
+    int ticks;              // ticks simulated (since the statistics were zeroed, see SimulationRun::branch)
+    int vehiclesGenerated;
+    int exits[4];           // vehicles that left the network, indexed by Direction
+    int rowsInUse;          // vehicle table rows still in use at the end, summed over the intersections
+    int highWaterMarks;     // each table's most rows in use at once, summed over the intersections
+    double meanTravelTicks; // per vehicle and lane crossed: ticks from entering the lane to leaving it
+    double meanDelayTicks;  // per vehicle and lane crossed: ticks beyond an unimpeded crossing
+    double seconds;         // wall clock time spent stepping
+};
+
+// Everything one simulation needs, so several can run side by side in one
+// process (e.g. on different threads): the network with its lanes, lights,
+// vehicles and random number streams, plus the simulation clock. The
+// config and layout must outlive the run.
+class SimulationRun
+{
+   private:
+      const SimulationConfig& config;
+      unsigned int seed;
+      Network network;
+      int tick;       // next tick to simulate
+      double seconds; // wall clock time spent in runToEnd
+      bool skipIdle;  // runToEnd jumps over ticks on which the network is empty
+      std::string checkpointFile; // runToEnd writes a checkpoint here...
+      int checkpointInterval;     // ...every this many ticks (0 = never)
+      int nextCheckpoint;         // tick at which the next one is due
+      int measuredFrom;           // tick the statistics were last reset at...
+      int vehiclesBefore;         // ...and how many vehicles had been generated by then
+
+      void checkpointIfDue(std::chrono::steady_clock::time_point startTime);
+      unsigned int restore(CheckpointReader& in, bool sameSeed);
+
+   public:
+      SimulationRun(const SimulationConfig& config, const NetworkLayout& layout, unsigned int seed);
+      SimulationRun(const SimulationRun& other) = delete;
+      SimulationRun& operator=(const SimulationRun& other) = delete;
+
+      // simulate a single tick
+      inline void step() { network.step(tick++); }
+
+      // switch to next-event mode (see Intersection::scheduleArrivals):
+      // runToEnd then jumps straight from a tick that leaves the network
+      // empty to the next arrival, unless it has an afterTick to call
+      void enableIdleSkipping();
+
+      // write a checkpoint to fileName each time runToEnd reaches a multiple
+      // of interval ticks (each replaces the one before)
+      void setCheckpoints(const std::string& fileName, int interval);
+
+      // Checkpoints: save() writes the whole state of the run (see
+      // Checkpoint.h) and resume() loads one into a run constructed with the
+      // same config, layout and seed, after which it carries on exactly as
+      // the run that wrote it would have. resume() exits with a message if
+      // the checkpoint is damaged or was written for a different run.
+      void save(const std::string& fileName) const;
+      void save(CheckpointWriter& out) const;
+      void resume(const std::string& fileName);
+
+      // Warm-up branching: load a state saved (in memory) by another run
+      // with the same config and layout, then carry on with this run's own
+      // seed, as if every intersection had been reseeded at that tick, and
+      // with the statistics zeroed so getResult() only covers the ticks
+      // from there on. A run given the snapshot's own seed continues
+      // exactly as the run it came from.
+      void branch(const CheckpointWriter& snapshot);
+
+      // simulate every remaining tick back to back (headless), calling
+      // afterTick (if given) with the number of each tick once it is done
+      void runToEnd(const std::function<void(int)>& afterTick = nullptr);
+      // the same, but stopping before tick endTick
+      void runUntil(int endTick, const std::function<void(int)>& afterTick = nullptr);
+
+      inline bool finished() const { return tick >= config.maximum_simulated_time; }
+      inline int getTick() const { return tick; }
+      inline unsigned int getSeed() const { return seed; }
+      inline Network& getNetwork() { return network; }
+
+      RunResult getResult() const;
+};
+
+#endif
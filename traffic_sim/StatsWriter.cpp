@@ -0,0 +1,266 @@
+#ifndef __STATS_WRITER_CPP__
+#define __STATS_WRITER_CPP__
+
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include "StatsWriter.h"
+
+using namespace::std;
+
+static const char STATS_MAGIC[] = "TSSTATS1";
+static const uint32_t STATS_VERSION = 1;
+static const char* const DIRECTION_NAMES[] = {"north", "south", "east", "west"};
+static const char* const LIGHT_NAMES[] = {"green", "yellow", "red"};
+
+// the bytes of value, little endian, at p; returns the end
+static char* putFixed(char* p, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        *p++ = static_cast<char>(value >> (8 * i));
+    return p;
+}
+
+// one i32 column of a block: field (or element d of it) in every record
+static char* putColumn(char* p, const StatsRecord* records, int n, int32_t StatsRecord::* field)
+{
+    for (int i = 0; i < n; i++)
+        p = putFixed(p, records[i].*field, 4);
+    return p;
+}
+
+static char* putColumn(char* p, const StatsRecord* records, int n, int32_t (StatsRecord::* field)[4], int d)
+{
+    for (int i = 0; i < n; i++)
+        p = putFixed(p, (records[i].*field)[d], 4);
+    return p;
+}
+
+static char* putNumber(char* p, int32_t value)
+{
+    return to_chars(p, p + 16, value).ptr;
+}
+
+static char* putText(char* p, const char* text)
+{
+    while (*text != '\0')
+        *p++ = *text++;
+    return p;
+}
+
+StatsWriter::StatsWriter(const string& fileName, StatsFormat format)
+    : fileName(fileName), format(format), closing(false), failed(false)
+{
+    file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr)
+    {
+        cerr << "Could not write stats file " << fileName << endl;
+        exit(0);
+    }
+
+    char header[512];
+    char* p = header;
+    if (format == StatsFormat::binary)
+    {
+        p = putText(p, STATS_MAGIC);
+        p = putFixed(p, STATS_VERSION, 4);
+    }
+    else
+    {
+        p = putText(p, "tick,intersection,light_north_south,light_east_west");
+        for (const char* column : {"queue_", "arrivals_", "departures_"})
+        {
+            for (int d = 0; d < 4; d++)
+            {
+                *p++ = ',';
+                p = putText(p, column);
+                p = putText(p, DIRECTION_NAMES[d]);
+            }
+        }
+        *p++ = '\n';
+    }
+    fwrite(header, 1, p - header, file);
+
+    // every buffer is allocated up front; record() never allocates
+    for (Block& block : blocks)
+    {
+        block.records.reset(new StatsRecord[BLOCK_RECORDS]);
+        block.count = 0;
+    }
+    filling = &blocks[0];
+    for (int b = 1; b < BLOCKS; b++)
+        free.push_back(&blocks[b]);
+    writer = thread(&StatsWriter::writerLoop, this);
+}
+
+StatsWriter::~StatsWriter()
+{
+    close();
+}
+
+void StatsWriter::start(Network& network)
+{
+    int intersections = network.size();
+    previousArrivals.resize(intersections * 4);
+    previousDepartures.resize(intersections * 4);
+    for (int k = 0; k < intersections; k++)
+    {
+        const TrafficCounters& counters = network.at(k / network.getColumns(), k % network.getColumns()).getCounters();
+        for (int d = 0; d < 4; d++)
+        {
+            previousArrivals[k * 4 + d] = counters.total(counters.arrivals, static_cast<Direction>(d));
+            previousDepartures[k * 4 + d] = counters.total(counters.departures, static_cast<Direction>(d));
+        }
+    }
+}
+
+void StatsWriter::record(int tick, Network& network)
+{
+    int intersections = network.size();
+
+    for (int k = 0; k < intersections; k++)
+    {
+        if (filling->count == BLOCK_RECORDS)
+            handOff();
+
+        Intersection& intersection = network.at(k / network.getColumns(), k % network.getColumns());
+        const TrafficCounters& counters = intersection.getCounters();
+        StatsRecord& record = filling->records[filling->count++];
+        record.tick = tick;
+        record.intersection = k;
+        record.northSouthLight = static_cast<uint8_t>(intersection.getLightNorthSouth());
+        record.eastWestLight = static_cast<uint8_t>(intersection.getLightEastWest());
+        for (int d = 0; d < 4; d++)
+        {
+            Direction direction = static_cast<Direction>(d);
+            long long arrivals = counters.total(counters.arrivals, direction);
+            long long departures = counters.total(counters.departures, direction);
+            record.queue[d] = intersection.getQueueLength(direction);
+            record.arrivals[d] = arrivals - previousArrivals[k * 4 + d];
+            record.departures[d] = departures - previousDepartures[k * 4 + d];
+            previousArrivals[k * 4 + d] = arrivals;
+            previousDepartures[k * 4 + d] = departures;
+        }
+    }
+}
+
+// queue the full block for the writer and take a free one, waiting for the writer if there is none
+void StatsWriter::handOff()
+{
+    unique_lock<std::mutex> lock(mutex);
+    queued.push_back(filling);
+    blockReady.notify_one();
+    blockWritten.wait(lock, [this] { return !free.empty(); });
+    filling = free.back();
+    free.pop_back();
+    filling->count = 0;
+}
+
+void StatsWriter::writerLoop()
+{
+    // room for a block in either format: a CSV row is at most 15 numbers of
+    // up to 11 characters, two light names and the separators
+    vector<char> text(4 + BLOCK_RECORDS * 256);
+    while (true)
+    {
+        Block* block;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            blockReady.wait(lock, [this] { return closing || !queued.empty(); });
+            if (queued.empty())
+                return;
+            block = queued.front();
+            queued.pop_front();
+        }
+
+        writeBlock(*block, text);
+
+        {
+            lock_guard<std::mutex> lock(mutex);
+            free.push_back(block);
+        }
+        blockWritten.notify_one();
+    }
+}
+
+void StatsWriter::writeBlock(const Block& block, vector<char>& text)
+{
+    const StatsRecord* records = block.records.get();
+    int n = block.count;
+    char* p = text.data();
+    if (format == StatsFormat::binary)
+    {
+        p = putFixed(p, n, 4);
+        p = putColumn(p, records, n, &StatsRecord::tick);
+        p = putColumn(p, records, n, &StatsRecord::intersection);
+        for (int i = 0; i < n; i++)
+            *p++ = records[i].northSouthLight;
+        for (int i = 0; i < n; i++)
+            *p++ = records[i].eastWestLight;
+        for (int d = 0; d < 4; d++)
+            p = putColumn(p, records, n, &StatsRecord::queue, d);
+        for (int d = 0; d < 4; d++)
+            p = putColumn(p, records, n, &StatsRecord::arrivals, d);
+        for (int d = 0; d < 4; d++)
+            p = putColumn(p, records, n, &StatsRecord::departures, d);
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+        {
+            const StatsRecord& record = records[i];
+            p = putNumber(p, record.tick);
+            *p++ = ',';
+            p = putNumber(p, record.intersection);
+            *p++ = ',';
+            p = putText(p, LIGHT_NAMES[record.northSouthLight]);
+            *p++ = ',';
+            p = putText(p, LIGHT_NAMES[record.eastWestLight]);
+            for (int d = 0; d < 4; d++)
+            {
+                *p++ = ',';
+                p = putNumber(p, record.queue[d]);
+            }
+            for (int d = 0; d < 4; d++)
+            {
+                *p++ = ',';
+                p = putNumber(p, record.arrivals[d]);
+            }
+            for (int d = 0; d < 4; d++)
+            {
+                *p++ = ',';
+                p = putNumber(p, record.departures[d]);
+            }
+            *p++ = '\n';
+        }
+    }
+    size_t size = p - text.data();
+    if (fwrite(text.data(), 1, size, file) != size)
+        failed = true;
+}
+
+void StatsWriter::close()
+{
+    if (file == nullptr)
+        return;
+
+    // the partly filled block goes last
+    {
+        lock_guard<std::mutex> lock(mutex);
+        if (filling->count > 0)
+            queued.push_back(filling);
+        closing = true;
+    }
+    blockReady.notify_one();
+    writer.join();
+
+    bool written = !failed && fclose(file) == 0;
+    file = nullptr;
+    if (!written)
+    {
+        cerr << "Could not write stats file " << fileName << endl;
+        exit(0);
+    }
+}
+
+#endif
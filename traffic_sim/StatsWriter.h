@@ -0,0 +1,99 @@
+#ifndef __STATS_WRITER_H__
+#define __STATS_WRITER_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Network.h"
+
+// One intersection at the end of one tick, as StatsWriter exports it.
+// Fixed size, so a block of them is a single flat array.
+struct StatsRecord
+{
+    int32_t tick;
+    int32_t intersection;     // row-major index in the network
+    uint8_t northSouthLight;  // LightColor
+    uint8_t eastWestLight;
+    int32_t queue[4];         // sections waiting at the stop line, by Direction
+    int32_t arrivals[4];      // vehicles that entered each lane on this tick
+    int32_t departures[4];    // vehicles whose last section left each lane on this tick
+};
+
+enum class StatsFormat {csv, binary};
+
+// Binary stats file layout (all integers little endian):
+//    header:   "TSSTATS1", u32 version
+//    blocks:   u32 record count n, then the records column by column:
+//              tick i32[n], intersection i32[n], north-south light u8[n],
+//              east-west light u8[n], then queue, arrivals and departures,
+//              each as four i32[n] columns in Direction order
+// Blocks follow each other up to the end of the file; a reader can
+// concatenate the columns of successive blocks.
+//
+// Per-tick time series of every intersection's lights, queues, arrivals
+// and departures, written by a background thread so the file I/O stays
+// out of the tick. The simulation thread fills preallocated blocks of
+// records; each full block is handed to the writer thread, which formats
+// it (CSV or the columnar format above) and writes it with one large
+// fwrite. If the writer falls behind and every block is waiting to be
+// written, record() blocks until one is free again rather than growing
+// the buffers.
+class StatsWriter
+{
+   private:
+      static const int BLOCK_RECORDS = 8192;
+      static const int BLOCKS = 8;
+
+      struct Block
+      {
+         std::unique_ptr<StatsRecord[]> records;
+         int count;
+      };
+
+      FILE* file;
+      std::string fileName;
+      StatsFormat format;
+      Block blocks[BLOCKS];
+      Block* filling;                 // the block record() is adding to (simulation thread only)
+      std::vector<long long> previousArrivals;   // totals at the last record, per intersection and
+      std::vector<long long> previousDepartures; // direction (simulation thread only)
+
+      std::mutex mutex;
+      std::condition_variable blockWritten; // a block went back on the free list
+      std::condition_variable blockReady;   // a block was queued, or close() was called
+      std::deque<Block*> queued;            // full blocks, oldest first
+      std::vector<Block*> free;
+      bool closing;
+      bool failed;                          // a write failed (checked in close())
+      std::thread writer;
+
+      void writerLoop();
+      void writeBlock(const Block& block, std::vector<char>& text);
+      void handOff();
+
+   public:
+      StatsWriter(const std::string& fileName, StatsFormat format);
+      ~StatsWriter(); // close()
+      StatsWriter(const StatsWriter& other) = delete;
+      StatsWriter& operator=(const StatsWriter& other) = delete;
+
+      // take the network's totals so far as the point the first record
+      // counts from (a resumed run's restored counters); call before the
+      // first tick is stepped
+      void start(Network& network);
+
+      // append one record per intersection for the end of the given tick
+      void record(int tick, Network& network);
+
+      // write what is left, stop the writer thread and close the file;
+      // exits with a message if any write failed
+      void close();
+};
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef __SWEEP_CPP__
+#define __SWEEP_CPP__
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include "Sweep.h"
+#include "Checkpoint.h"
+#include "Config.h"
+#include "Network.h"
+#include "SimulationRun.h"
+#include "Replications.h"
+
+using namespace::std;
+
+// values of one spec line (whitespace already removed): "a..bstepc" or "v1,v2,..."
+static bool parseSweepValues(const string& text, vector<double>& values)
+{
+    try
+    {
+        size_t range = text.find("..");
+        if (range != string::npos)
+        {
+            size_t step = text.find("step", range);
+            if (step == string::npos)
+                return false;
+            double first = stod(text.substr(0, range));
+            double last = stod(text.substr(range + 2, step - range - 2));
+            double increment = stod(text.substr(step + 4));
+            if (increment <= 0 || last < first)
+                return false;
+            // count the steps up front so floating point steps don't drop the last value
+            int count = static_cast<int>(floor((last - first) / increment + 1e-9)) + 1;
+            for (int i = 0; i < count; i++)
+                values.push_back(first + i * increment);
+            return true;
+        }
+
+        stringstream list(text);
+        string value;
+        while (getline(list, value, ','))
+            values.push_back(stod(value));
+        return !values.empty();
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+}
+
+vector<SweepDimension> readSweepSpec(const string& fileName, const map<string, double>& input_dict)
+{
+    ifstream infile {fileName};
+    if (!infile)
+    {
+        cerr << "Unable to open file: " << fileName << endl;
+        exit(0);
+    }
+
+    vector<SweepDimension> dimensions;
+    string line;
+    while (getline(infile, line))
+    {
+        // same layout rules as the input file: whitespace doesn't matter, blank lines are skipped
+        line.erase(std::remove_if(line.begin(), line.end(), [](char c) { return std::isspace(c); }), line.end());
+        if (line.length() == 0)
+            continue;
+
+        size_t colon = line.find(':');
+        SweepDimension dimension;
+        if (colon != string::npos)
+            dimension.key = line.substr(0, colon);
+        if (colon == string::npos || !parseSweepValues(line.substr(colon + 1), dimension.values))
+        {
+            cerr << "Unable to read sweep line in " << fileName << ": " << line << endl;
+            exit(0);
+        }
+        if (input_dict.count(dimension.key) == 0)
+        {
+            cerr << "Sweep key " << dimension.key << " is not in the input file" << endl;
+            exit(0);
+        }
+        dimensions.push_back(dimension);
+    }
+    return dimensions;
+}
+
+void runSweep(const map<string, double>& input_dict, const vector<SweepDimension>& dimensions,
+    const string& networkFile, unsigned int firstSeed, int replications, ThreadPool& pool, ostream& csv,
+    bool skipIdle, int warmupTicks)
+{
+    int points = 1;
+    for (const SweepDimension& dimension : dimensions)
+        points *= dimension.values.size();
+
+    // build every point's config and layout before starting so the tasks can share them read-only;
+    // points are numbered with the last dimension varying fastest
+    vector<map<string, double>> inputs(points, input_dict);
+    vector<SimulationConfig> configs(points);
+    vector<NetworkLayout> layouts(points);
+    for (int p = 0; p < points; p++)
+    {
+        int remainder = p;
+        for (int d = dimensions.size() - 1; d >= 0; d--)
+        {
+            int count = dimensions[d].values.size();
+            inputs[p][dimensions[d].key] = dimensions[d].values[remainder % count];
+            remainder /= count;
+        }
+        configs[p] = makeConfig(inputs[p]);
+        layouts[p] = networkFile.empty() ? singleIntersectionLayout(configs[p]) : readNetworkLayout(networkFile, configs[p]);
+        if (warmupTicks >= configs[p].maximum_simulated_time)
+        {
+            cerr << "--warmup " << warmupTicks << " leaves no ticks of the " << configs[p].maximum_simulated_time
+                 << " to measure at sweep point " << p << endl;
+            exit(0);
+        }
+    }
+
+    // warm every point up once with firstSeed, in parallel, and keep the states to branch from
+    vector<CheckpointWriter> snapshots(warmupTicks > 0 ? points : 0);
+    for (int p = 0; p < static_cast<int>(snapshots.size()); p++)
+    {
+        pool.submit([&configs, &layouts, &snapshots, firstSeed, p, skipIdle, warmupTicks]
+        {
+            SimulationRun warmup(configs[p], layouts[p], firstSeed);
+            if (skipIdle)
+                warmup.enableIdleSkipping();
+            warmup.runUntil(warmupTicks);
+            warmup.save(snapshots[p]);
+        });
+    }
+    pool.wait();
+
+    // one task per (point, seed) so the pool can balance long and short points against each other
+    vector<vector<RunResult>> results(points, vector<RunResult>(replications));
+    for (int p = 0; p < points; p++)
+    {
+        for (int r = 0; r < replications; r++)
+        {
+            pool.submit([&configs, &layouts, &results, &snapshots, firstSeed, p, r, skipIdle, warmupTicks]
+            {
+                SimulationRun run(configs[p], layouts[p], firstSeed + r);
+                if (warmupTicks > 0)
+                    run.branch(snapshots[p]);
+                else if (skipIdle)
+                    run.enableIdleSkipping();
+                run.runToEnd();
+                results[p][r] = run.getResult();
+            });
+        }
+    }
+    pool.wait();
+
+    csv << "point";
+    for (const SweepDimension& dimension : dimensions)
+        csv << "," << dimension.key;
+    csv << ",replications,vehicles_generated,exits_per_tick,exits_per_tick_ci95,mean_travel_ticks,mean_delay_ticks,mean_delay_ticks_ci95" << endl;
+
+    for (int p = 0; p < points; p++)
+    {
+        vector<double> generated, throughput, travel, delay;
+        for (const RunResult& result : results[p])
+        {
+            int totalExited = 0;
+            for (int d = 0; d < 4; d++)
+                totalExited += result.exits[d];
+            generated.push_back(result.vehiclesGenerated);
+            throughput.push_back(result.ticks > 0 ? static_cast<double>(totalExited) / result.ticks : 0);
+            travel.push_back(result.meanTravelTicks);
+            delay.push_back(result.meanDelayTicks);
+        }
+        SummaryStatistic throughputStatistic = summarize(throughput);
+        SummaryStatistic delayStatistic = summarize(delay);
+
+        csv << p;
+        for (const SweepDimension& dimension : dimensions)
+            csv << "," << inputs[p].at(dimension.key);
+        csv << "," << replications << "," << summarize(generated).mean
+            << "," << throughputStatistic.mean << "," << throughputStatistic.halfWidth
+            << "," << summarize(travel).mean
+            << "," << delayStatistic.mean << "," << delayStatistic.halfWidth << endl;
+    }
+}
+
+#endif
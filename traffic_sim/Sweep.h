@@ -0,0 +1,37 @@
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+// one input file key and the values a sweep tries for it
+struct SweepDimension
+{
+    std::string key;
+    std::vector<double> values;
+};
+
+// Read a sweep spec: one line per swept input file key, either a list or
+// an inclusive range with a step, e.g.
+//    green_north_south:           8, 10, 12, 14
+//    prob_new_vehicle_eastbound:  0.05 .. 0.3 step 0.05
+// Exits with a message for a key the input file doesn't have or a line
+// that can't be read.
+std::vector<SweepDimension> readSweepSpec(const std::string& fileName, const std::map<std::string, double>& input_dict);
+
+// Run every point of the cartesian product of the dimensions (the values
+// from input_dict for every other key) with seeds firstSeed ...
+// firstSeed + replications - 1 each, as independent tasks on the pool, and
+// write one CSV row per point with its throughput and delay. networkFile,
+// if not empty, is read for every point so per-point signal timings apply.
+// skipIdle and warmupTicks work as for runReplications, with one warm-up
+// per point; exits with a message if a point's maximum_simulated_time
+// leaves no ticks after the warm-up.
+void runSweep(const std::map<std::string, double>& input_dict, const std::vector<SweepDimension>& dimensions,
+    const std::string& networkFile, unsigned int firstSeed, int replications, ThreadPool& pool, std::ostream& csv,
+    bool skipIdle = false, int warmupTicks = 0);
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef __THREAD_POOL_CPP__
+#define __THREAD_POOL_CPP__
+
+#include "ThreadPool.h"
+
+using namespace::std;
+
+// the pool and worker index of the current thread, if it is a pool worker
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int threads) : queued(0), nextQueue(0), outstanding(0), stopping(false)
+{
+    if (threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    for (int i = 0; i < threads; i++)
+        queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue()));
+    for (int i = 0; i < threads; i++)
+        workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+    int target;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        outstanding++;
+        if (currentPool == this)
+            target = currentWorker;
+        else
+        {
+            target = nextQueue;
+            nextQueue = (nextQueue + 1) % queues.size();
+        }
+    }
+
+    {
+        lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(move(task));
+    }
+
+    // counted under the pool mutex so a worker going to sleep can't miss it
+    {
+        lock_guard<std::mutex> lock(mutex);
+        queued++;
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return outstanding == 0; });
+}
+
+// newest task from this worker's own deque, otherwise the oldest task of the first other worker that has one
+bool ThreadPool::takeTask(int worker, function<void()>& task)
+{
+    {
+        WorkerQueue& own = *queues[worker];
+        lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    int count = queues.size();
+    for (int i = 1; i < count; i++)
+    {
+        WorkerQueue& victim = *queues[(worker + i) % count];
+        lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int worker)
+{
+    currentPool = this;
+    currentWorker = worker;
+
+    while (true)
+    {
+        function<void()> task;
+        if (!takeTask(worker, task))
+        {
+            unique_lock<std::mutex> lock(mutex);
+            taskReady.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0)
+                return; // nothing left to run
+            continue;
+        }
+
+        task();
+
+        lock_guard<std::mutex> lock(mutex);
+        if (--outstanding == 0)
+            allDone.notify_all();
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with work stealing: each worker has its own
+// task deque, takes new work from the back of it, and when it runs dry
+// steals from the front of another worker's deque. Tasks submitted from
+// outside the pool are dealt round-robin across the workers; tasks
+// submitted by a running task go to that worker's own deque.
+class ThreadPool
+{
+   private:
+      struct WorkerQueue
+      {
+         std::mutex mutex;
+         std::deque<std::function<void()>> tasks;
+      };
+
+      std::vector<std::thread> workers;
+      std::vector<std::unique_ptr<WorkerQueue>> queues; // one per worker
+      std::atomic<int> queued;  // tasks sitting in any queue
+      int nextQueue;            // round-robin target for outside submissions
+
+      std::mutex mutex;
+      std::condition_variable taskReady; // signalled when a task is queued or the pool is stopping
+      std::condition_variable allDone;   // signalled when the last outstanding task finishes
+      int outstanding; // tasks queued or running
+      bool stopping;
+
+      bool takeTask(int worker, std::function<void()>& task);
+      void workerLoop(int worker);
+
+   public:
+      // threads <= 0 uses one thread per hardware core
+      ThreadPool(int threads);
+      ~ThreadPool();
+      ThreadPool(const ThreadPool& other) = delete;
+      ThreadPool& operator=(const ThreadPool& other) = delete;
+
+      void submit(std::function<void()> task);
+
+      // block until every submitted task has finished
+      void wait();
+
+      inline int size() const { return workers.size(); }
+};
+
+#endif
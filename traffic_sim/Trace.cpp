@@ -0,0 +1,290 @@
+#ifndef __TRACE_CPP__
+#define __TRACE_CPP__
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Trace.h"
+#include "Varint.h"
+
+using namespace::std;
+
+static const char TRACE_MAGIC[] = "TSTRACE1";
+static const char INDEX_MAGIC[] = "TSINDEX1";
+static const uint32_t TRACE_VERSION = 1;
+static const uint8_t KEYFRAME_TAG = 1;
+static const uint8_t DELTA_TAG = 2;
+static const size_t FOOTER_TAIL = 8 + 8 + 8; // keyframe count, frame count, magic
+
+static void putFixed(vector<uint8_t>& buffer, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+static uint64_t getFixed(const uint8_t* p, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return value;
+}
+
+//======================================================================
+//* TraceWriter
+//======================================================================
+TraceWriter::TraceWriter(const string& fileName, int numSectionsBefore, int keyframeInterval)
+    : fileName(fileName), numSectionsBefore(numSectionsBefore), keyframeInterval(keyframeInterval), offset(0), frameCount(0)
+{
+    file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr)
+    {
+        cerr << "Unable to open trace file for writing: " << fileName << endl;
+        exit(0);
+    }
+
+    buffer.insert(buffer.end(), TRACE_MAGIC, TRACE_MAGIC + 8);
+    putFixed(buffer, TRACE_VERSION, 4);
+    putFixed(buffer, numSectionsBefore, 4);
+    putFixed(buffer, keyframeInterval, 4);
+    flushBuffer();
+}
+
+TraceWriter::~TraceWriter()
+{
+    for (uint64_t keyframeOffset : keyframeOffsets)
+        putFixed(buffer, keyframeOffset, 8);
+    putFixed(buffer, keyframeOffsets.size(), 8);
+    putFixed(buffer, frameCount, 8);
+    buffer.insert(buffer.end(), INDEX_MAGIC, INDEX_MAGIC + 8);
+    flushBuffer();
+    if (fclose(file) != 0)
+    {
+        cerr << "Could not write trace file " << fileName << endl;
+        exit(0);
+    }
+}
+
+void TraceWriter::putCell(const TraceCell& cell)
+{
+    putVarint(buffer, static_cast<uint64_t>(cell.vehicleID + 1));
+    if (cell.vehicleID != -1)
+        buffer.push_back(static_cast<uint8_t>(static_cast<int>(cell.type) | static_cast<int>(cell.direction) << 4));
+}
+
+void TraceWriter::flushBuffer()
+{
+    if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+    {
+        cerr << "Could not write trace file " << fileName << endl;
+        exit(0);
+    }
+    offset += buffer.size();
+    buffer.clear();
+}
+
+void TraceWriter::record(int tick, Intersection& intersection)
+{
+    captureFrame(tick, intersection, current);
+
+    bool keyframe = frameCount % keyframeInterval == 0;
+    if (keyframe)
+        keyframeOffsets.push_back(offset);
+
+    buffer.push_back(keyframe ? KEYFRAME_TAG : DELTA_TAG);
+    putVarint(buffer, tick);
+    buffer.push_back(static_cast<uint8_t>(static_cast<int>(current.northSouthLight) | static_cast<int>(current.eastWestLight) << 4));
+
+    if (keyframe)
+    {
+        for (const TraceCell& cell : current.cells)
+            putCell(cell);
+    }
+    else
+    {
+        int changes = 0;
+        for (int i = 0; i < static_cast<int>(current.cells.size()); i++)
+            if (current.cells[i] != previous.cells[i])
+                changes++;
+        putVarint(buffer, changes);
+
+        int last = 0;
+        for (int i = 0; i < static_cast<int>(current.cells.size()); i++)
+        {
+            if (current.cells[i] != previous.cells[i])
+            {
+                putVarint(buffer, i - last);
+                putCell(current.cells[i]);
+                last = i;
+            }
+        }
+    }
+
+    flushBuffer();
+    swap(previous, current);
+    frameCount++;
+}
+
+//======================================================================
+//* TraceReader
+//======================================================================
+static void refuse(const string& fileName, const string& reason)
+{
+    cerr << "Cannot replay " << fileName << ": " << reason << endl;
+    exit(0);
+}
+
+TraceReader::TraceReader(const string& fileName) : data(nullptr), size(0)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0)
+    {
+        cerr << "Unable to open file: " << fileName << endl;
+        exit(0);
+    }
+    size = status.st_size;
+    if (size >= 20 + FOOTER_TAIL)
+    {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+            data = static_cast<const uint8_t*>(mapped);
+    }
+    close(fd);
+
+    if (data == nullptr || memcmp(data, TRACE_MAGIC, 8) != 0 || memcmp(data + size - 8, INDEX_MAGIC, 8) != 0
+        || getFixed(data + 8, 4) != TRACE_VERSION)
+        refuse(fileName, "not a complete trace file");
+
+    // everything below indexes into the map, so check it fits before trusting it
+    uint64_t sectionsBefore = getFixed(data + 12, 4);
+    uint64_t interval = getFixed(data + 16, 4);
+    uint64_t keyframeCount = getFixed(data + size - FOOTER_TAIL, 8);
+    frameCount = getFixed(data + size - FOOTER_TAIL + 8, 8);
+    if (sectionsBefore > INT32_MAX / 8)
+        refuse(fileName, "bad number of sections in the header");
+    if (interval == 0 || interval > INT32_MAX)
+        refuse(fileName, "bad keyframe interval in the header");
+    if (keyframeCount > (size - 20 - FOOTER_TAIL) / 8 || frameCount > INT32_MAX
+        || keyframeCount != (frameCount + interval - 1) / interval)
+        refuse(fileName, "the index doesn't match the file");
+
+    numSectionsBefore = sectionsBefore;
+    keyframeInterval = interval;
+    keyframeIndex = data + size - FOOTER_TAIL - keyframeCount * 8;
+    for (uint64_t k = 0; k < keyframeCount; k++)
+    {
+        uint64_t keyframeOffset = getFixed(keyframeIndex + k * 8, 8);
+        if (keyframeOffset < 20 || keyframeOffset >= static_cast<uint64_t>(keyframeIndex - data)
+            || data[keyframeOffset] != KEYFRAME_TAG)
+            refuse(fileName, "the index doesn't match the file");
+    }
+}
+
+TraceReader::~TraceReader()
+{
+    munmap(const_cast<uint8_t*>(data), size);
+}
+
+TraceCell TraceReader::getCell(const uint8_t*& p) const
+{
+    TraceCell cell = {static_cast<VehicleID>(getVarint(p)) - 1, VehicleType::none, Direction::north};
+    if (cell.vehicleID != -1)
+    {
+        cell.type = static_cast<VehicleType>(*p & 0x0f);
+        cell.direction = static_cast<Direction>(*p >> 4);
+        p++;
+    }
+    return cell;
+}
+
+// decode the record at p on top of frame (the previous frame, for a delta); returns the next record
+const uint8_t* TraceReader::decodeRecord(const uint8_t* p, TraceFrame& frame) const
+{
+    uint8_t tag = *p++;
+    frame.tick = getVarint(p);
+    frame.northSouthLight = static_cast<LightColor>(*p & 0x0f);
+    frame.eastWestLight = static_cast<LightColor>(*p >> 4);
+    p++;
+
+    if (tag == KEYFRAME_TAG)
+    {
+        for (TraceCell& cell : frame.cells)
+            cell = getCell(p);
+    }
+    else
+    {
+        int changes = getVarint(p);
+        int position = 0;
+        for (int i = 0; i < changes; i++)
+        {
+            position += getVarint(p);
+            frame.cells[position] = getCell(p);
+        }
+    }
+    return p;
+}
+
+void TraceReader::readFrame(int n, TraceFrame& frame) const
+{
+    frame.cells.resize(4 * (numSectionsBefore * 2 + 2));
+
+    // start from the keyframe at or before frame n and apply the deltas after it
+    int keyframe = n / keyframeInterval;
+    const uint8_t* p = data + getFixed(keyframeIndex + keyframe * 8, 8);
+    for (int i = keyframe * keyframeInterval; i <= n; i++)
+        p = decodeRecord(p, frame);
+}
+
+//======================================================================
+//* frameLanes
+//======================================================================
+void captureFrame(int tick, Intersection& intersection, TraceFrame& frame)
+{
+    VehicleTable& vehicles = intersection.getVehicles();
+    frame.tick = tick;
+    frame.northSouthLight = intersection.getLightNorthSouth();
+    frame.eastWestLight = intersection.getLightEastWest();
+    int length = intersection.getLane(Direction::north).size();
+    frame.cells.resize(4 * length);
+    int c = 0;
+    for (int d = 0; d < 4; d++)
+    {
+        Lane& lane = intersection.getLane(static_cast<Direction>(d));
+        for (int i = 0; i < length; i++, c++)
+        {
+            VehicleIndex vehicle = lane[i];
+            if (vehicle == NO_VEHICLE)
+                frame.cells[c] = {-1, VehicleType::none, Direction::north};
+            else
+                frame.cells[c] = {vehicles.getVehicleID(vehicle), vehicles.getType(vehicle), vehicles.getDirection(vehicle)};
+        }
+    }
+}
+
+void frameLanes(const TraceFrame& frame, int numSectionsBefore, VehicleTable& table, vector<VehicleBase*> lanes[4])
+{
+    int length = numSectionsBefore * 2 + 2;
+
+    // add every row first: adding rows can grow the table, which moves its views
+    vector<VehicleIndex> rows(frame.cells.size(), NO_VEHICLE);
+    for (int c = 0; c < static_cast<int>(frame.cells.size()); c++)
+    {
+        const TraceCell& cell = frame.cells[c];
+        if (cell.vehicleID != -1)
+            rows[c] = table.admit(cell.vehicleID, cell.type, cell.direction, Turn::straight, 1, frame.tick);
+    }
+
+    for (int d = 0; d < 4; d++)
+    {
+        lanes[d].resize(length);
+        for (int i = 0; i < length; i++)
+            lanes[d][i] = table.view(rows[d * length + i]);
+    }
+}
+
+#endif
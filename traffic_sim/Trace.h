@@ -0,0 +1,122 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Intersection.h"
+#include "VehicleBase.h"
+#include "VehicleTable.h"
+
+// What the Animator shows of one section: the ID, type and direction of
+// the vehicle in it (vehicleID -1 when empty).
+struct TraceCell
+{
+    VehicleID   vehicleID;
+    VehicleType type;
+    Direction   direction;
+
+    inline bool operator==(const TraceCell& other) const
+    {
+        return vehicleID == other.vehicleID && (vehicleID == -1 || (type == other.type && direction == other.direction));
+    }
+    inline bool operator!=(const TraceCell& other) const { return !(*this == other); }
+};
+
+// One tick of one intersection as drawn: both light colors and the cells
+// of the four lanes, lane by lane in Direction order (north, south, east,
+// west), each lane in index order.
+struct TraceFrame
+{
+    int tick;
+    LightColor northSouthLight;
+    LightColor eastWestLight;
+    std::vector<TraceCell> cells;
+};
+
+// Trace file layout (all integers little endian):
+//    header:   "TSTRACE1", u32 version, u32 sections before the
+//              intersection, u32 keyframe interval K
+//    frames:   one record per tick, in tick order; every K-th (starting
+//              with the first) is a keyframe holding every cell, the rest
+//              hold only the cells that changed since the previous tick
+//    footer:   u64 file offset of each keyframe, then u64 keyframe count,
+//              u64 frame count and "TSINDEX1"
+// A record is a tag byte (1 keyframe, 2 delta), the tick and lights, then
+// either every cell, or the number of changed cells followed by each one
+// as the gap from the previous changed cell's position plus the cell.
+// Counts, gaps and ticks are LEB128 varints; a cell is varint(vehicleID + 1)
+// followed, if not empty, by one byte holding its type and direction.
+
+// Records the frames of one intersection while a simulation runs.
+class TraceWriter
+{
+   private:
+      FILE* file;
+      std::string fileName;
+      int numSectionsBefore;
+      int keyframeInterval;
+      uint64_t offset;                 // bytes written so far
+      std::vector<uint64_t> keyframeOffsets;
+      uint64_t frameCount;
+      TraceFrame previous;             // last frame written, for deltas
+      TraceFrame current;
+      std::vector<uint8_t> buffer;     // encoded record being built
+
+      void putCell(const TraceCell& cell);
+      void flushBuffer();
+
+   public:
+      // both exit with a message if the file can't be written (a full disk)
+      TraceWriter(const std::string& fileName, int numSectionsBefore, int keyframeInterval);
+      ~TraceWriter(); // writes the index footer and closes the file
+      TraceWriter(const TraceWriter& other) = delete;
+      TraceWriter& operator=(const TraceWriter& other) = delete;
+
+      // append the state of the intersection at the end of the given tick
+      void record(int tick, Intersection& intersection);
+};
+
+// Reads a trace file through a read-only memory map. Any frame can be
+// reached by decoding at most K records starting from the keyframe at or
+// before it, so seeking costs the same wherever in the file the tick is.
+class TraceReader
+{
+   private:
+      const uint8_t* data;
+      size_t size;
+      int numSectionsBefore;
+      int keyframeInterval;
+      uint64_t frameCount;
+      const uint8_t* keyframeIndex; // the footer's keyframe offsets
+
+      TraceCell getCell(const uint8_t*& p) const;
+      const uint8_t* decodeRecord(const uint8_t* p, TraceFrame& frame) const;
+
+   public:
+      // exits with a message if the file isn't a trace or its header or
+      // footer don't fit the file
+      TraceReader(const std::string& fileName);
+      ~TraceReader();
+      TraceReader(const TraceReader& other) = delete;
+      TraceReader& operator=(const TraceReader& other) = delete;
+
+      inline int getNumSectionsBefore() const { return numSectionsBefore; }
+      inline int getFrameCount() const { return frameCount; }
+
+      // decode frame number n (0 <= n < getFrameCount())
+      void readFrame(int n, TraceFrame& frame) const;
+};
+
+// Fill frame with the state of the intersection at the end of the given
+// tick, exactly as the Animator would be handed it. Once frame.cells has
+// grown to the intersection's size, this doesn't allocate.
+void captureFrame(int tick, Intersection& intersection, TraceFrame& frame);
+
+// Fill lanes[d] (indexed by Direction) with VehicleBase views of the
+// frame's cells, in the form the Animator's setVehicles* methods take. The
+// views are backed by rows added to table, which should be empty.
+void frameLanes(const TraceFrame& frame, int numSectionsBefore, VehicleTable& table, std::vector<VehicleBase*> lanes[4]);
+
+#endif
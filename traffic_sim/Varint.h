@@ -0,0 +1,34 @@
+#ifndef __VARINT_H__
+#define __VARINT_H__
+
+#include <cstdint>
+#include <vector>
+
+// LEB128 varints, as the trace and checkpoint files store counts: seven
+// bits per byte, low bits first, with the high bit set on every byte but
+// the last, so small values take a single byte.
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// decode the varint at p and move p past it
+inline uint64_t getVarint(const uint8_t*& p)
+{
+    uint64_t value = 0;
+    int shift = 0;
+    while (*p & 0x80)
+    {
+        value |= static_cast<uint64_t>(*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= static_cast<uint64_t>(*p++) << shift;
+    return value;
+}
+
+#endif
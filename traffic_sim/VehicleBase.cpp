@@ -2,67 +2,38 @@
 #define __VEHICLE_BASE_CPP__
 
 #include "VehicleBase.h"
+#include "VehicleTable.h"
 
 using namespace::std;
 
-int VehicleBase::vehicleCount = 0;
-
-// common use constructor
-VehicleBase::VehicleBase(VehicleType type, Direction direction, Turn turn) : vehicleID(VehicleBase::vehicleCount++), vehicleType(type), vehicleDirection(direction), vehicleTurn(turn)
+VehicleBase::VehicleBase(const VehicleTable* table, VehicleIndex index) : table(table), index(index)
 {
-    bool isStopping = false;
+
 }
 
-// copy constructor
-VehicleBase::VehicleBase(const VehicleBase& other) : vehicleID(other.vehicleID), vehicleType(other.vehicleType), vehicleDirection(other.vehicleDirection), vehicleTurn(other.vehicleTurn)
+VehicleID VehicleBase::getVehicleID() const
 {
-    
+    return table->getVehicleID(index);
 }
 
-// copy assignment operator
-VehicleBase& VehicleBase::operator=(const VehicleBase& other)
+VehicleType VehicleBase::getVehicleType() const
 {
-    if (this == &other) 
-    {
-        return *this;
-    }
-    vehicleID = other.vehicleID;
-    vehicleType = other.vehicleType;
-    vehicleDirection = other.vehicleDirection;
-    vehicleTurn = other.vehicleTurn;
-    return *this;
+    return table->getType(index);
 }
 
-// move constructor
-VehicleBase::VehicleBase(VehicleBase&& other)noexcept : vehicleID(other.vehicleID), vehicleType(other.vehicleType), vehicleDirection(other.vehicleDirection), vehicleTurn(other.vehicleTurn)
+Direction VehicleBase::getVehicleOriginalDirection() const
 {
-    other.vehicleID = 0;
-    other.vehicleType = VehicleType::destructible;
-    other.vehicleDirection = Direction::destructible;
-    other.vehicleTurn = Turn::destructible;
+    return table->getDirection(index);
 }
 
-// move assignment operator
-VehicleBase& VehicleBase::operator=(VehicleBase&& other)noexcept
+Turn VehicleBase::getVehicleTurn() const
 {
-    if (this == &other) 
-    {
-        return *this;
-    }
-    vehicleID = other.vehicleID;
-    vehicleType = other.vehicleType;
-    vehicleDirection = other.vehicleDirection;
-    vehicleTurn = other.vehicleTurn;
-    other.vehicleID = 0;
-    other.vehicleType = VehicleType::destructible;
-    other.vehicleDirection = Direction::destructible;
-    other.vehicleTurn = Turn::destructible;
-    return *this;
+    return table->getTurn(index);
 }
 
-VehicleBase::~VehicleBase() 
+int VehicleBase::getVehicleEntryTick() const
 {
-    
+    return table->getEntryTick(index);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,38 +1,41 @@
 #ifndef __VEHICLE_BASE_H__
 #define __VEHICLE_BASE_H__
 
+#include <cstdint>
+
 // enum: see http://isocpp.github.io/CppCoreGuidelines/CppCoreGuidelines#S-enum
 enum class Direction   {north, south, east, west, destructible};
 enum class VehicleType {car, suv, truck, none, destructible};
 enum class LightColor  {green, yellow, red, destructible};
 enum class Turn        {left, right, straight, destructible};
 
+// row of a vehicle in the VehicleTable; lanes hold one per section
+typedef uint32_t VehicleIndex;
+const VehicleIndex NO_VEHICLE = 0; // an empty section
+
+// ID of a vehicle, unique across a network; 64 bits since every
+// intersection's IDs are spaced out by the number of intersections
+typedef int64_t VehicleID;
+
+class VehicleTable;
+
+// Read-only view of one vehicle stored in a VehicleTable, kept so the
+// Animator can keep working with VehicleBase pointers.
 class VehicleBase
 {
-   public:
-      static int vehicleCount;
-
    private:
-      int         vehicleID;    
-      bool isStopping;
-      VehicleType vehicleType;
-      Direction   vehicleDirection;
-      Turn        vehicleTurn;
+      const VehicleTable* table;
+      VehicleIndex        index;
 
    public:
-      VehicleBase(VehicleType type, Direction originalDirection, Turn turn);
-      VehicleBase(const VehicleBase& other);
-      VehicleBase& operator=(const VehicleBase& other);
-      VehicleBase(VehicleBase&& other)noexcept;
-      VehicleBase& operator=(VehicleBase&& other)noexcept;
-      ~VehicleBase();
-
-      inline int getVehicleID() const { return this->vehicleID; }
-      inline bool        getVehicleStop() const {return this->isStopping; }
-      inline void        setVehicleStop(bool s) {this->isStopping = s; }
-      inline VehicleType getVehicleType() const { return this->vehicleType; }
-      inline Direction   getVehicleOriginalDirection() const { return this->vehicleDirection; }
-      inline Turn        getVehicleTurn() const {return this->vehicleTurn; }
+      VehicleBase(const VehicleTable* table, VehicleIndex index);
+
+      inline VehicleIndex getVehicleIndex() const { return this->index; }
+      VehicleID   getVehicleID() const;
+      VehicleType getVehicleType() const;
+      Direction   getVehicleOriginalDirection() const;
+      Turn        getVehicleTurn() const;
+      int         getVehicleEntryTick() const; // tick the vehicle entered its current lane
       
 };
 
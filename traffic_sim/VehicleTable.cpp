@@ -0,0 +1,126 @@
+#ifndef __VEHICLE_TABLE_CPP__
+#define __VEHICLE_TABLE_CPP__
+
+#include "Checkpoint.h"
+#include "VehicleTable.h"
+
+using namespace::std;
+
+VehicleTable::VehicleTable(int idOffset, int idStride) : freeHead(NO_VEHICLE), inUse(0), highWaterMark(0), vehicleCount(0),
+    idOffset(idOffset), idStride(idStride)
+{
+    grow(); // creates row 0 (reserved for NO_VEHICLE) along with the first free rows
+}
+
+// double the number of rows and chain the new ones onto the free list
+void VehicleTable::grow()
+{
+    int oldRows = vehicleIDs.size();
+    int newRows = oldRows == 0 ? 64 : oldRows * 2;
+
+    vehicleIDs.resize(newRows);
+    entryTicks.resize(newRows);
+    types.resize(newRows);
+    turns.resize(newRows);
+    directions.resize(newRows);
+    lengths.resize(newRows);
+    sectionsLeft.resize(newRows);
+    nextFree.resize(newRows);
+    for (int i = oldRows; i < newRows; i++)
+        views.push_back(VehicleBase(this, i));
+
+    for (int i = newRows - 1; i >= max(oldRows, 1); i--)
+    {
+        nextFree[i] = freeHead;
+        freeHead = i;
+    }
+}
+
+// pop a row off the free list
+VehicleIndex VehicleTable::takeRow()
+{
+    if (freeHead == NO_VEHICLE)
+        grow();
+
+    VehicleIndex index = freeHead;
+    freeHead = nextFree[index];
+
+    inUse++;
+    if (inUse > highWaterMark)
+        highWaterMark = inUse;
+    return index;
+}
+
+VehicleIndex VehicleTable::acquire(VehicleType type, Direction direction, Turn turn, int sections, int entryTick)
+{
+    VehicleIndex index = admit(static_cast<VehicleID>(vehicleCount) * idStride + idOffset, type, direction, turn, sections, entryTick);
+    sectionsLeft[index] = sections;
+    vehicleCount++;
+    return index;
+}
+
+VehicleIndex VehicleTable::admit(VehicleID vehicleID, VehicleType type, Direction direction, Turn turn, int sections, int entryTick)
+{
+    VehicleIndex index = takeRow();
+    vehicleIDs[index] = vehicleID;
+    entryTicks[index] = entryTick;
+    types[index] = static_cast<uint8_t>(type);
+    turns[index] = static_cast<uint8_t>(turn);
+    directions[index] = static_cast<uint8_t>(direction);
+    lengths[index] = sections;
+    sectionsLeft[index] = 1;
+    return index;
+}
+
+bool VehicleTable::releaseSection(VehicleIndex index)
+{
+    if (--sectionsLeft[index] > 0)
+        return false;
+
+    nextFree[index] = freeHead;
+    freeHead = index;
+    inUse--;
+    return true;
+}
+
+void VehicleTable::save(CheckpointWriter& out) const
+{
+    out.putVarints(vehicleIDs);
+    out.putWords(entryTicks);
+    out.putBytes(types);
+    out.putBytes(turns);
+    out.putBytes(directions);
+    out.putBytes(lengths);
+    out.putBytes(sectionsLeft);
+    out.putWords(nextFree);
+    out.put32(freeHead);
+    out.put32(inUse);
+    out.put32(highWaterMark);
+    out.put32(vehicleCount);
+}
+
+void VehicleTable::restore(CheckpointReader& in)
+{
+    vehicleIDs = in.getVarints();
+    entryTicks = in.getWords();
+    types = in.getBytes();
+    turns = in.getBytes();
+    directions = in.getBytes();
+    lengths = in.getBytes();
+    sectionsLeft = in.getBytes();
+    nextFree = in.getWords();
+    freeHead = in.get32();
+    inUse = in.get32();
+    highWaterMark = in.get32();
+    vehicleCount = in.get32();
+
+    size_t rows = vehicleIDs.size();
+    if (rows == 0 || entryTicks.size() != rows || types.size() != rows || turns.size() != rows || directions.size() != rows
+        || lengths.size() != rows || sectionsLeft.size() != rows || nextFree.size() != rows || freeHead >= rows)
+        in.fail("inconsistent vehicle table");
+    views.clear();
+    for (size_t i = 0; i < rows; i++)
+        views.push_back(VehicleBase(this, i));
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef __VEHICLE_TABLE_H__
+#define __VEHICLE_TABLE_H__
+
+#include <cstdint>
+#include <vector>
+#include "VehicleBase.h"
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// Owns every vehicle in the simulation as a row in a set of parallel,
+// packed arrays (struct of arrays). Lanes store the row index of the
+// vehicle occupying each section rather than a pointer, and the movement
+// code reads the one column it needs (usually the turn) straight out of a
+// dense array.
+//
+// Row 0 is never handed out so that NO_VEHICLE (0) can mark an empty
+// section. Rows whose vehicle has left the road go on a free list and are
+// reused, so the table stops growing once traffic reaches steady state.
+class VehicleTable
+{
+   private:
+      // one entry per row
+      std::vector<uint64_t>     vehicleIDs;   // the ID shown by the Animator
+      std::vector<uint32_t>     entryTicks;   // tick the vehicle entered its lane
+      std::vector<uint8_t>      types;        // VehicleType
+      std::vector<uint8_t>      turns;        // Turn
+      std::vector<uint8_t>      directions;   // original Direction
+      std::vector<uint8_t>      lengths;      // sections the vehicle occupies
+      std::vector<uint8_t>      sectionsLeft; // sections still on a lane
+      std::vector<VehicleIndex> nextFree;     // free list link for unused rows
+      std::vector<VehicleBase>  views;        // VehicleBase view of each row for the Animator
+
+      VehicleIndex freeHead; // first free row, NO_VEHICLE when none
+      int inUse;
+      int highWaterMark;     // most rows ever in use at once
+      int vehicleCount;      // vehicles created by acquire so far
+      int idOffset;          // vehicle IDs are vehicleCount * idStride + idOffset so that
+      int idStride;          // tables of different intersections never hand out the same ID
+
+      void grow();
+      VehicleIndex takeRow();
+
+   public:
+      VehicleTable(int idOffset = 0, int idStride = 1);
+      VehicleTable(const VehicleTable& other) = delete;
+      VehicleTable& operator=(const VehicleTable& other) = delete;
+
+      // add a new vehicle that will occupy the given number of sections
+      VehicleIndex acquire(VehicleType type, Direction direction, Turn turn, int sections, int entryTick);
+
+      // add a vehicle that arrived from another intersection, keeping its ID;
+      // it starts with one section and addSection counts each one after that
+      VehicleIndex admit(VehicleID vehicleID, VehicleType type, Direction direction, Turn turn, int sections, int entryTick);
+      inline void addSection(VehicleIndex index) { sectionsLeft[index]++; }
+
+      // called when one section of the vehicle leaves its lane; returns true
+      // when that was the vehicle's last section and its row has been freed
+      bool releaseSection(VehicleIndex index);
+
+      inline VehicleID   getVehicleID(VehicleIndex index) const { return vehicleIDs[index]; }
+      inline int         getEntryTick(VehicleIndex index) const { return entryTicks[index]; }
+      inline VehicleType getType(VehicleIndex index) const { return static_cast<VehicleType>(types[index]); }
+      inline Turn        getTurn(VehicleIndex index) const { return static_cast<Turn>(turns[index]); }
+      inline Direction   getDirection(VehicleIndex index) const { return static_cast<Direction>(directions[index]); }
+      inline int         getLength(VehicleIndex index) const { return lengths[index]; }
+      inline int         getSectionsLeft(VehicleIndex index) const { return sectionsLeft[index]; }
+
+      // VehicleBase view of a row (nullptr for NO_VEHICLE); only valid until
+      // the next acquire, which may grow the table
+      inline VehicleBase* view(VehicleIndex index)
+            { return index == NO_VEHICLE ? nullptr : &views[index]; }
+
+      inline int getInUse() const { return this->inUse; }
+      inline int getHighWaterMark() const { return this->highWaterMark; }
+      inline int getVehicleCount() const { return this->vehicleCount; }
+
+      // every row and the free list, for checkpoints (restore keeps this
+      // table's ID offset and stride)
+      void save(CheckpointWriter& out) const;
+      void restore(CheckpointReader& in);
+};
+
+#endif